@@ -1,49 +1,188 @@
 #pragma once
+#include <zephyr/kernel.h>
+#include <zephyr/input/input.h>
 #include "zephyr/shell/shell.h"
 #define ACCEL_CURVE_NVS_PREFIX "curves"
+#define ACCEL_CURVE_MAX_SLOTS 4
+
+// Event type of output the processor re-injects itself. The tag travels with the event, the
+// processor turns it back into INPUT_EV_REL when it passes through, without processing it again.
+#define ACCEL_CURVE_EV_INJECT (INPUT_EV_VENDOR_START + 0x0a)
 
 struct point {
-    int16_t x;
-    int16_t y;
+    int32_t x;
+    int32_t y;
 };
 
-struct accel_point {
-    int16_t x;
-    float y_coef;
+// Packed lookup table: x is the input speed (x100) shifted right by x_shift, coef is the multiplier
+// in unsigned fixed point with CONFIG_ZMK_ACCEL_CURVE_COEF_FRAC_BITS fractional bits.
+struct accel_lut {
+    uint16_t* x;
+    uint16_t* coef;
+    uint16_t num_points;
+    uint8_t x_shift;
 };
 
+struct accel_lut_entry;
+
 struct curve {
     struct point start, end, cp1, cp2;
 };
 
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_HISTOGRAM)
+#define ACCEL_CURVE_HIST_MAGIC { 'A', 'C', 'H', 'S' }
+
+struct accel_curve_histogram {
+    uint32_t velocity[CONFIG_ZMK_ACCEL_CURVE_HISTOGRAM_BINS];
+    uint32_t coef[CONFIG_ZMK_ACCEL_CURVE_HISTOGRAM_BINS];
+};
+
+// Exported blob: this header, then velocity[bins] and coef[bins] as native-endian uint32.
+struct accel_curve_hist_header {
+    char magic[4];
+    uint8_t version;
+    uint8_t bins;
+    uint16_t coef_step;
+} __packed;
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_CAPTURE)
+#define ACCEL_CURVE_CAPTURE_MAGIC { 'A', 'C', 'R', 'C' }
+#define ACCEL_CAPTURE_MAX_CODES 2
+
+#define ACCEL_CAPTURE_VERSION 3
+
+// Capture record, one uint32 per input frame of the two event codes:
+//   bits  0..10  value of event code 0 (int11, saturated)
+//   bit  11      event code 0 present
+//   bits 12..22  value of event code 1 (int11, saturated)
+//   bit  23      event code 1 present
+//   bits 24..31  time since the previous frame in ACCEL_CAPTURE_DT_UNIT_US steps, up to ACCEL_CAPTURE_DT_MAX
+// A frame closes on sync, or when an axis repeats before sync. A longer pause is stored as a gap
+// record ahead of the frame (dt ACCEL_CAPTURE_DT_GAP), holding the pause in microseconds in bits
+// 0..23 (saturated at ~16.7 s). The frame after it has dt 0.
+#define ACCEL_CAPTURE_DT_UNIT_US 4
+#define ACCEL_CAPTURE_DT_MAX     0xfeU
+#define ACCEL_CAPTURE_DT_GAP     0xffU
+#define ACCEL_CAPTURE_FRAME(dt)  ((uint32_t)(dt) << 24)
+#define ACCEL_CAPTURE_AXIS(axis, value)                                  \
+    ((((uint32_t)CLAMP((int32_t)(value), -1024, 1023) & 0x7ffU) | BIT(11)) << (12 * (axis)))
+#define ACCEL_CAPTURE_GAP(dt_us)                                         \
+    (MIN((uint32_t)(dt_us), 0xffffffU) | ACCEL_CAPTURE_FRAME(ACCEL_CAPTURE_DT_GAP))
+#define ACCEL_CAPTURE_PRESENT(rec, axis) (((rec) & (BIT(11) << (12 * (axis)))) != 0)
+#define ACCEL_CAPTURE_VALUE(rec, axis)   ((int32_t)((uint32_t)(rec) << (21 - 12 * (axis))) >> 21)
+#define ACCEL_CAPTURE_DT_US(rec)         (((rec) >> 24) * ACCEL_CAPTURE_DT_UNIT_US)
+#define ACCEL_CAPTURE_IS_GAP(rec)        (((rec) >> 24) == ACCEL_CAPTURE_DT_GAP)
+#define ACCEL_CAPTURE_GAP_US(rec)        ((rec) & 0xffffffU)
+
+// Exported blob: this header followed by `count` records, oldest first, native-endian.
+struct accel_curve_capture_header {
+    char magic[4];
+    uint8_t version;
+    uint8_t event_codes_len;
+    uint16_t event_codes[ACCEL_CAPTURE_MAX_CODES];
+    uint32_t count;
+    uint32_t overwritten;
+} __packed;
+#endif
+
 struct zip_accel_curve_config {
     const uint8_t max_curves, points;
     const uint8_t event_codes_len;
     const bool couple_axes;
+    const bool glide;
+    // per mille of speed kept per tick, then counts x100 per tick
+    const uint16_t glide_decay, glide_friction, glide_min_speed;
+    const uint8_t* curve_slots;
     const char* device_name;
     const uint16_t event_codes[];
 };
 
 struct zip_accel_curve_data {
     const struct device *dev;
+    uint8_t id;
     bool initialized;
     struct curve* curves;
-    struct accel_point* points;
+    // const struct accel_lut*, NULL for an empty slot. An import swaps the pointer and frees the
+    // previous table only once lut_readers drops to zero.
+    atomic_ptr_t luts[ACCEL_CURVE_MAX_SLOTS];
+    atomic_t lut_readers;
+    struct accel_lut_entry* lut_entries[ACCEL_CURVE_MAX_SLOTS];
+    uint8_t num_slots;
     uint8_t num_curves;
-    uint16_t num_points;
     float* remainders;
     int64_t dz_last_active_ms;
     int32_t* buffered_values;
     bool* buffered_present;
-    bool* inject_pass;
+    bool dry_run;
+    struct k_spinlock couple_lock;
+    struct k_work_delayable couple_flush_work;
+    bool couple_flush_armed;
+    const struct device *couple_input_dev;
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_GLIDE)
+    // glide velocity and sub-count position are Q8 counts per tick
+    struct k_spinlock glide_lock;
+    struct k_work_delayable glide_work;
+    const struct device *glide_input_dev;
+    int32_t glide_acc[2];
+    int32_t glide_v[2];
+    int32_t glide_pos[2];
+    uint16_t glide_empty_ticks;
+    bool glide_active;
+    bool glide_armed;
+#endif
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_HISTOGRAM)
+    struct accel_curve_histogram hist;
+#endif
+    struct k_work save_work;
+    atomic_ptr_t save_pending[ACCEL_CURVE_MAX_SLOTS];
 };
 
 void curves_init();
-int data_import(const struct device* dev, const char* datastring);
+int data_import(const struct device* dev, uint8_t slot, const char* datastring);
 const struct device* device_by_name(const char* name);
+int accel_curve_parse_slot(const char* str, uint8_t num_slots);
 int dump_curves(const struct shell *, const char* name);
 int list_devices(char*** names);
+size_t accel_curve_ram_usage(const struct device* dev);
 
 #if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_MONITOR)
 void accel_curve_monitoring_set(bool enabled, bool abs);
 #endif
+
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_HISTOGRAM)
+const struct accel_curve_histogram* accel_curve_hist_get(const struct device* dev);
+void accel_curve_hist_reset(const struct device* dev);
+int accel_curve_hist_export(const struct device* dev, uint8_t* buf, size_t len);
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_CAPTURE)
+int accel_curve_capture_start(const struct device* dev, uint32_t seconds);
+void accel_curve_capture_stop(void);
+bool accel_curve_capture_active(void);
+uint32_t accel_curve_capture_count(void);
+size_t accel_curve_capture_export(size_t offset, uint8_t* buf, size_t len);
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_BENCH)
+#define ACCEL_CURVE_BENCH_MAX_RESULTS 6
+
+enum accel_curve_bench_pattern {
+    ACCEL_CURVE_BENCH_SWEEP,
+    ACCEL_CURVE_BENCH_SLOW,
+    ACCEL_CURVE_BENCH_FAST,
+    ACCEL_CURVE_BENCH_CAPTURE,
+};
+
+struct accel_curve_bench_result {
+    uint16_t lut_points;
+    bool coupled;
+    uint32_t events;
+    uint64_t cycles;
+    uint64_t ns;
+};
+
+int accel_curve_bench(const struct device* dev, uint32_t iterations, enum accel_curve_bench_pattern pattern,
+                      struct accel_curve_bench_result* results, size_t max_results);
+
+#endif
@@ -1,3 +1,4 @@
+#include <ctype.h>
 #include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -20,11 +21,38 @@
 #define ZRC_GET(key, default_val) (default_val)
 #endif
 
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_BENCH)
+#include <zephyr/timing/timing.h>
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_TRACING)
+#include <zephyr/tracing/tracing.h>
+// CTF truncates event names to 19 characters, stage tags are kept short enough for "acc_<tag>_out"
+#define ACCEL_TRACE_EVENT(name, dev_id, arg)                                                     \
+    do {                                                                                          \
+        BUILD_ASSERT(sizeof(name) <= 20, "Trace event name too long: " name);                     \
+        sys_trace_named_event(name, (dev_id), (arg));                                             \
+    } while (0)
+#define ACCEL_TRACE_ENTER(stage, dev_id, arg)  ACCEL_TRACE_EVENT("acc_" stage "_in", dev_id, arg)
+#define ACCEL_TRACE_EXIT(stage, dev_id, arg)   ACCEL_TRACE_EVENT("acc_" stage "_out", dev_id, arg)
+#define ACCEL_TRACE_RESULT(stage, dev_id, rc)  ACCEL_TRACE_EVENT("acc_" stage "_rc", dev_id, (uint32_t)(rc))
+#else
+#define ACCEL_TRACE_ENTER(stage, dev_id, code) do { ARG_UNUSED(dev_id); ARG_UNUSED(code); } while (0)
+#define ACCEL_TRACE_EXIT(stage, dev_id, code)  do { ARG_UNUSED(dev_id); ARG_UNUSED(code); } while (0)
+#define ACCEL_TRACE_RESULT(stage, dev_id, rc)  do { ARG_UNUSED(dev_id); ARG_UNUSED(rc); } while (0)
+#endif
+
+// device id of trace events that are not tied to one device
+#define ACCEL_TRACE_NO_DEV 0xFF
+
 #define DT_DRV_COMPAT zmk_accel_curve
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 #define ACCEL_CURVE_DATA_MAX_LEN 1024
 
+#define ACCEL_COEF_ONE   (1U << CONFIG_ZMK_ACCEL_CURVE_COEF_FRAC_BITS)
+#define ACCEL_COEF_SCALE (1.0f / (float)ACCEL_COEF_ONE)
+
 #if IS_ENABLED(CONFIG_ZMK_RUNTIME_CONFIG)
 static uint32_t g_zrc_cache_last_refresh = 0;
 static bool     g_zrc_cache_initialized  = false;
@@ -66,6 +94,7 @@ static __attribute__((noinline)) void zrc_cache_refresh_if_due(const uint32_t no
         return;
     }
 
+    ACCEL_TRACE_ENTER("zrc", ACCEL_TRACE_NO_DEV, 0);
     for (size_t i = 0; i < ARRAY_SIZE(zrc_cache_tbl); i++) {
         const struct zrc_cache_entry *e = &zrc_cache_tbl[i];
         const int32_t v = zrc_get(e->key);
@@ -77,6 +106,7 @@ static __attribute__((noinline)) void zrc_cache_refresh_if_due(const uint32_t no
 
     g_zrc_cache_last_refresh = now;
     g_zrc_cache_initialized  = true;
+    ACCEL_TRACE_EXIT("zrc", ACCEL_TRACE_NO_DEV, 0);
 }
 #else
 static inline void zrc_cache_refresh_if_due(const uint32_t now) { ARG_UNUSED(now); }
@@ -84,19 +114,48 @@ static inline void zrc_cache_refresh_if_due(const uint32_t now) { ARG_UNUSED(now
 
 static const struct device* devices[DT_NUM_INST_STATUS_OKAY(DT_DRV_COMPAT)];
 static uint8_t num_dev = 0;
-static struct k_work_delayable load_curves_work;
-static bool work_initialized = false;
+static struct k_work load_curves_work;
+K_MUTEX_DEFINE(import_lock);
+
+K_THREAD_STACK_DEFINE(accel_curve_wq_stack, CONFIG_ZMK_ACCEL_CURVE_WORKQUEUE_STACK_SIZE);
+BUILD_ASSERT(CONFIG_ZMK_ACCEL_CURVE_WORKQUEUE_PRIORITY < CONFIG_NUM_PREEMPT_PRIORITIES,
+             "Work queue priority must be a preemptible thread priority");
+static struct k_work_q accel_curve_wq;
+static bool wq_started = false;
+
+static void accel_curve_wq_start(void) {
+    if (wq_started) {
+        return;
+    }
+
+    const struct k_work_queue_config cfg = { .name = "accel_curve_wq" };
+    k_work_queue_start(&accel_curve_wq, accel_curve_wq_stack, K_THREAD_STACK_SIZEOF(accel_curve_wq_stack),
+                       CONFIG_ZMK_ACCEL_CURVE_WORKQUEUE_PRIORITY, &cfg);
+    wq_started = true;
+}
 
-static int16_t bezier_eval(const int16_t p0, const int16_t p1, const int16_t p2, const int16_t p3, const float t) {
+static int32_t bezier_eval(const int32_t p0, const int32_t p1, const int32_t p2, const int32_t p3, const float t) {
     const float u = 1.0f - t;
     const float tt = t * t;
     const float uu = u * u;
     const float uuu = uu * u;
     const float ttt = tt * t;
-    return (int16_t) (uuu * p0 + 3 * uu * t * p1 + 3 * u * tt * p2 + ttt * p3);
+    return (int32_t) (uuu * p0 + 3 * uu * t * p1 + 3 * u * tt * p2 + ttt * p3);
 }
 
-static int set_curves(const struct device* dev, const char* datastring) {
+static uint16_t coef_to_fixed(const int32_t y) {
+    const int64_t fixed = ((int64_t)y * ACCEL_COEF_ONE + 50) / 100;
+    if (fixed < 0) {
+        return 0;
+    }
+    if (fixed > UINT16_MAX) {
+        LOG_WRN("Coefficient %d.%02d exceeds table range, clamping", y / 100, y % 100);
+        return UINT16_MAX;
+    }
+    return (uint16_t)fixed;
+}
+
+static int parse_curves(const struct device* dev, const char* datastring) {
     struct zip_accel_curve_data *data = dev->data;
     const struct zip_accel_curve_config *config = dev->config;
 
@@ -106,9 +165,9 @@ static int set_curves(const struct device* dev, const char* datastring) {
 
     uint8_t curve_count = 0;
     const char* ptr = datastring;
-    int16_t values[8];
+    int values[8];
     while (*ptr && curve_count < config->max_curves) {
-        const int parsed = sscanf(ptr, "%hd %hd %hd %hd %hd %hd %hd %hd",
+        const int parsed = sscanf(ptr, "%d %d %d %d %d %d %d %d",
             &values[0], &values[1], &values[2], &values[3],
             &values[4], &values[5], &values[6], &values[7]);
 
@@ -150,46 +209,192 @@ static int set_curves(const struct device* dev, const char* datastring) {
         }
     }
 
-    const uint32_t points_per_curve = curve_count > 0 ? config->points / curve_count : 0;
+    return curve_count;
+}
+
+static int build_lut(const struct curve* curves, const uint8_t curve_count, const uint16_t points, struct accel_lut *lut) {
+    const uint32_t points_per_curve = curve_count > 0 ? points / curve_count : 0;
     uint32_t point_idx = 0;
 
-    for (uint8_t curve_idx = 0; curve_idx < curve_count && point_idx < config->points; curve_idx++) {
-        const struct curve *c = &data->curves[curve_idx];
+    // Speeds past the uint16 range are stored shifted right, the curve stays inside its control points' hull
+    int32_t x_max = 0;
+    for (uint8_t curve_idx = 0; curve_idx < curve_count; curve_idx++) {
+        const struct curve *c = &curves[curve_idx];
+        x_max = MAX(x_max, MAX(MAX(c->start.x, c->end.x), MAX(c->cp1.x, c->cp2.x)));
+    }
+    lut->x_shift = 0;
+    while ((x_max >> lut->x_shift) > UINT16_MAX) {
+        lut->x_shift++;
+    }
+
+    for (uint8_t curve_idx = 0; curve_idx < curve_count && point_idx < points; curve_idx++) {
+        const struct curve *c = &curves[curve_idx];
         const uint32_t num_points = (curve_idx == curve_count - 1)
-            ? (config->points - point_idx)
+            ? (points - point_idx)
             : points_per_curve;
 
-        for (uint32_t i = 0; i < num_points && point_idx < config->points; i++) {
+        for (uint32_t i = 0; i < num_points && point_idx < points; i++) {
             const float t = (float) i / (float) (num_points - 1);
-            const int16_t x = bezier_eval(c->start.x, c->cp1.x, c->cp2.x, c->end.x, t);
-            const int16_t y = bezier_eval(c->start.y, c->cp1.y, c->cp2.y, c->end.y, t);
+            const int32_t x = bezier_eval(c->start.x, c->cp1.x, c->cp2.x, c->end.x, t);
+            const int32_t y = bezier_eval(c->start.y, c->cp1.y, c->cp2.y, c->end.y, t);
 
             if (x < 100) {
                 continue;
             }
 
-            data->points[point_idx].x = x;
-            data->points[point_idx].y_coef = y / 100.0f;
+            lut->x[point_idx] = (uint16_t)(x >> lut->x_shift);
+            lut->coef[point_idx] = coef_to_fixed(y);
             point_idx++;
         }
     }
 
     for (uint32_t i = 1; i < point_idx; i++) {
-        if (data->points[i].x < data->points[i-1].x && !(points_per_curve % i == 0 && data->points[i].x == data->points[i-1].x)) {
+        if (lut->x[i] < lut->x[i-1] && !(points_per_curve % i == 0 && lut->x[i] == lut->x[i-1])) {
             LOG_ERR("Invalid point sequence: X values must be strictly increasing at index %d/%d", i, point_idx);
             return -EINVAL;
         }
     }
 
-    data->num_points = (uint16_t)point_idx;
-    return curve_count;
+    lut->num_points = (uint16_t)point_idx;
+    return 0;
+}
+
+struct accel_lut_entry {
+    uint32_t hash;
+    uint16_t points;
+    uint8_t refcnt;
+    uint8_t curve_count;
+    struct curve* defs;
+    struct accel_lut lut;
+};
+
+// Tables are keyed by the parsed curve definition and point count, identical curves share one table.
+// Entries live on the heap so a table can leave the store while a reader still holds it.
+// Guarded by import_lock.
+static struct accel_lut_entry* g_lut_store[CONFIG_ZMK_ACCEL_CURVE_LUT_STORE_SIZE];
+
+static uint32_t lut_hash(const struct curve* curves, const uint8_t curve_count, const uint16_t points) {
+    // FNV-1a
+    uint32_t hash = 2166136261U;
+    const uint8_t *bytes = (const uint8_t *)curves;
+    for (size_t i = 0; i < sizeof(struct curve) * curve_count; i++) {
+        hash = (hash ^ bytes[i]) * 16777619U;
+    }
+    hash = (hash ^ (points & 0xff)) * 16777619U;
+    hash = (hash ^ (points >> 8)) * 16777619U;
+    return hash;
+}
+
+// `reusable` is the table the caller is about to release, its place counts as free when nothing else uses it.
+static struct accel_lut_entry* lut_store_acquire(const struct curve* curves, const uint8_t curve_count,
+                                                 const uint16_t points, const struct accel_lut_entry* reusable) {
+    const uint32_t hash = lut_hash(curves, curve_count, points);
+    struct accel_lut_entry **slot = NULL;
+    for (size_t i = 0; i < ARRAY_SIZE(g_lut_store); i++) {
+        struct accel_lut_entry *e = g_lut_store[i];
+        if (e == NULL) {
+            if (slot == NULL) {
+                slot = &g_lut_store[i];
+            }
+            continue;
+        }
+
+        if (e->hash == hash && e->points == points && e->curve_count == curve_count &&
+            memcmp(e->defs, curves, sizeof(struct curve) * curve_count) == 0) {
+            e->refcnt++;
+            LOG_DBG("Sharing lookup table %08x (%d users)", hash, e->refcnt);
+            return e;
+        }
+    }
+
+    // the old table keeps its memory until the caller releases it, only its place is handed over
+    for (size_t i = 0; i < ARRAY_SIZE(g_lut_store) && slot == NULL && reusable != NULL && reusable->refcnt == 1; i++) {
+        if (g_lut_store[i] == reusable) {
+            slot = &g_lut_store[i];
+        }
+    }
+
+    if (slot == NULL) {
+        LOG_ERR("Lookup table store is full");
+        return NULL;
+    }
+
+    struct accel_lut_entry *e = malloc(sizeof(*e));
+    if (!e) {
+        LOG_ERR("Failed to allocate memory for curves or points");
+        return NULL;
+    }
+    *e = (struct accel_lut_entry){
+        .hash = hash,
+        .points = points,
+        .refcnt = 1,
+        .curve_count = curve_count,
+        .defs = malloc(sizeof(struct curve) * curve_count),
+        // x values and coefficients share one allocation, coefficients follow the x values
+        .lut.x = malloc(sizeof(uint16_t) * 2 * points),
+    };
+    if (!e->defs || !e->lut.x) {
+        LOG_ERR("Failed to allocate memory for curves or points");
+        goto fail;
+    }
+
+    e->lut.coef = e->lut.x + points;
+    memcpy(e->defs, curves, sizeof(struct curve) * curve_count);
+    if (build_lut(curves, curve_count, points, &e->lut) != 0) {
+        goto fail;
+    }
+
+    *slot = e;
+    return e;
+
+fail:
+    free(e->defs);
+    free(e->lut.x);
+    free(e);
+    return NULL;
+}
+
+// Callers detach the table from every reader first, see lut_slot_swap().
+static void lut_store_release(struct accel_lut_entry* e) {
+    if (e == NULL || --e->refcnt > 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(g_lut_store); i++) {
+        if (g_lut_store[i] == e) {
+            g_lut_store[i] = NULL;
+        }
+    }
+    free(e->lut.x);
+    free(e->defs);
+    free(e);
+}
+
+// Publishes the new table in one pointer store, then waits out readers that may still hold the old one.
+static void lut_slot_swap(struct zip_accel_curve_data *data, const uint8_t slot, struct accel_lut_entry* entry) {
+    struct accel_lut_entry *old = data->lut_entries[slot];
+    atomic_ptr_set(&data->luts[slot], entry != NULL ? &entry->lut : NULL);
+    data->lut_entries[slot] = entry;
+    while (old != NULL && atomic_get(&data->lut_readers) > 0) {
+        k_msleep(1);
+    }
+    lut_store_release(old);
+}
+
+static void curve_setting_name(char* buf, const size_t len, const char* device_name, const uint8_t slot) {
+    // slot 0 keeps the original key so curves saved before slots existed still load
+    if (slot == 0) {
+        snprintf(buf, len, "%s/%s", ACCEL_CURVE_NVS_PREFIX, device_name);
+    } else {
+        snprintf(buf, len, "%s/%s/%u", ACCEL_CURVE_NVS_PREFIX, device_name, slot);
+    }
 }
 
-static int save_curves_to_nvs(const struct device* dev, const char* datastring) {
+static int save_curves_to_nvs(const struct device* dev, const uint8_t slot, const char* datastring) {
     const struct zip_accel_curve_config *config = dev->config;
 
     char setting_name[32];
-    snprintf(setting_name, sizeof(setting_name), "%s/%s", ACCEL_CURVE_NVS_PREFIX, config->device_name);
+    curve_setting_name(setting_name, sizeof(setting_name), config->device_name, slot);
 
     const int rc = settings_save_one(setting_name, datastring, strlen(datastring) + 1);
     if (rc != 0) {
@@ -201,37 +406,32 @@ static int save_curves_to_nvs(const struct device* dev, const char* datastring)
     return 0;
 }
 
-static int load_cb(const char *key, const size_t len, const settings_read_cb read_cb, void *cb_arg, void *param) {
-    const struct device* dev = param;
-    if (len == 0 || len > ACCEL_CURVE_DATA_MAX_LEN) {
-        LOG_ERR("Invalid curve data length: %u", (unsigned)len);
-        return -EINVAL;
-    }
-    char data[len];
-    const int read = read_cb(cb_arg, &data, len);
-    if (read == 0) {
-        LOG_ERR("Failed to read curve: no data read");
-        return -EACCES;
-    }
-
-    return data_import(dev, data);
-}
+static void save_curves_work_handler(struct k_work *work) {
+    struct zip_accel_curve_data *data = CONTAINER_OF(work, struct zip_accel_curve_data, save_work);
+    for (uint8_t slot = 0; slot < data->num_slots; slot++) {
+        char* datastring = atomic_ptr_clear(&data->save_pending[slot]);
+        if (datastring == NULL) {
+            continue;
+        }
 
-static int load_curves_from_nvs(const struct device* dev) {
-    const struct zip_accel_curve_config *config = dev->config;
-    char setting_name[32];
-    snprintf(setting_name, sizeof(setting_name), "%s/%s", ACCEL_CURVE_NVS_PREFIX, config->device_name);
-    return settings_load_subtree_direct(setting_name, load_cb, (struct device*) dev);
+        ACCEL_TRACE_ENTER("nvs_save", data->id, slot);
+        save_curves_to_nvs(data->dev, slot, datastring);
+        ACCEL_TRACE_EXIT("nvs_save", data->id, slot);
+        free(datastring);
+    }
 }
 
-static void load_curves_work_handler(struct k_work *work) {
-    LOG_INF("Loading curves from NVS for all %d devices", num_dev);
-
-    for (uint8_t i = 0; i < num_dev; i++) {
-        if (devices[i] != NULL) {
-            load_curves_from_nvs(devices[i]);
-        }
+static void save_curves_deferred(const struct device* dev, const uint8_t slot, const char* datastring) {
+    struct zip_accel_curve_data *data = dev->data;
+    char* copy = strdup(datastring);
+    if (copy == NULL) {
+        LOG_ERR("Failed to allocate memory for deferred save");
+        return;
     }
+
+    // only the latest pending curve is written, older ones are dropped
+    free(atomic_ptr_set(&data->save_pending[slot], copy));
+    k_work_submit_to_queue(&accel_curve_wq, &data->save_work);
 }
 
 static int dump_cb(const char *key, const size_t len, const settings_read_cb read_cb, void *cb_arg, void *param) {
@@ -281,7 +481,7 @@ int dump_curves(const struct shell *sh, const char* name) {
     return 0;
 }
 
-int data_import(const struct device* dev, const char* datastring) {
+static int curves_import(const struct device* dev, const uint8_t slot, const char* datastring, const bool persist) {
     if (dev == NULL) {
         LOG_ERR("Device not initialized");
         return -EINVAL;
@@ -289,12 +489,15 @@ int data_import(const struct device* dev, const char* datastring) {
 
     struct zip_accel_curve_data *data = dev->data;
     const struct zip_accel_curve_config *config = dev->config;
+    if (slot >= data->num_slots) {
+        LOG_ERR("Invalid curve slot %d, device has %d", slot, data->num_slots);
+        return -EINVAL;
+    }
 
-    free(data->points);
-    data->points = NULL;
+    k_mutex_lock(&import_lock, K_FOREVER);
+    ACCEL_TRACE_ENTER("import", data->id, slot);
 
     data->curves = malloc(sizeof(struct curve) * config->max_curves);
-    data->points = malloc(sizeof(struct accel_point) * config->points);
 
     if (!data->remainders) {
         data->remainders = malloc(sizeof(float) * config->event_codes_len);
@@ -308,41 +511,123 @@ int data_import(const struct device* dev, const char* datastring) {
     if (config->couple_axes && !data->buffered_values) {
         data->buffered_values = malloc(sizeof(int32_t) * config->event_codes_len);
         data->buffered_present = malloc(sizeof(bool) * config->event_codes_len);
-        data->inject_pass = malloc(sizeof(bool) * config->event_codes_len);
-        if (data->buffered_values && data->buffered_present && data->inject_pass) {
+        if (data->buffered_values && data->buffered_present) {
             for (uint8_t i = 0; i < config->event_codes_len; i++) {
                 data->buffered_values[i] = 0;
                 data->buffered_present[i] = false;
-                data->inject_pass[i] = false;
             }
         }
     }
 
-    if (!data->curves || !data->points) {
+    int curve_count = -EINVAL;
+    struct accel_lut_entry *entry = NULL;
+    if (!data->curves) {
         LOG_ERR("Failed to allocate memory for curves or points");
-        free(data->curves);
-        data->curves = NULL;
-        free(data->points);
-        data->points = NULL;
-        return -EINVAL;
+    } else {
+        curve_count = parse_curves(dev, datastring);
+        if (curve_count > 0) {
+            entry = lut_store_acquire(data->curves, curve_count, config->points, data->lut_entries[slot]);
+            if (entry == NULL) {
+                curve_count = -EINVAL;
+            }
+        }
+        LOG_INF("%d curves found", curve_count);
     }
 
-    const int curve_count = set_curves(dev, datastring);
-    LOG_INF("%d curves found", curve_count);
-
+    // a failed import keeps the previous table, re-setting the same curve shares it before the old reference goes
     if (curve_count > 0) {
-        data->initialized = true;
         data->num_curves = curve_count;
-        save_curves_to_nvs(dev, datastring);
-    } else {
-        data->initialized = false;
+        lut_slot_swap(data, slot, entry);
+        if (persist) {
+            save_curves_deferred(dev, slot, datastring);
+        }
     }
-    
+
+    data->initialized = false;
+    for (uint8_t i = 0; i < data->num_slots; i++) {
+        data->initialized |= atomic_ptr_get(&data->luts[i]) != NULL;
+    }
+
     free(data->curves);
     data->curves = NULL;
+    ACCEL_TRACE_RESULT("import", data->id, curve_count);
+    ACCEL_TRACE_EXIT("import", data->id, slot);
+    k_mutex_unlock(&import_lock);
     return curve_count;
 }
 
+int data_import(const struct device* dev, const uint8_t slot, const char* datastring) {
+    return curves_import(dev, slot, datastring, true);
+}
+
+// Keys below the prefix are "<device>" for slot 0 and "<device>/<slot>" for the others.
+static int curves_settings_set(const char *key, const size_t len, const settings_read_cb read_cb, void *cb_arg) {
+    const char *next = NULL;
+    const int name_len = settings_name_next(key, &next);
+
+    const struct device* dev = NULL;
+    for (uint8_t i = 0; i < num_dev && dev == NULL; i++) {
+        const struct zip_accel_curve_config *config = devices[i]->config;
+        if (strlen(config->device_name) == (size_t)name_len && strncmp(config->device_name, key, name_len) == 0) {
+            dev = devices[i];
+        }
+    }
+    if (dev == NULL) {
+        LOG_WRN("Ignoring curve for unknown device: %s", key);
+        return 0;
+    }
+
+    const struct zip_accel_curve_data *dev_data = dev->data;
+    const int parsed = next == NULL ? 0 : accel_curve_parse_slot(next, dev_data->num_slots);
+    if (parsed < 0) {
+        LOG_ERR("Ignoring curve for unknown slot: %s", key);
+        return 0;
+    }
+    const uint8_t slot = (uint8_t)parsed;
+
+    if (len == 0 || len > ACCEL_CURVE_DATA_MAX_LEN) {
+        LOG_ERR("Invalid curve data length: %u", (unsigned)len);
+        return -EINVAL;
+    }
+    char data[len];
+    const ssize_t read = read_cb(cb_arg, &data, len);
+    if (read <= 0) {
+        LOG_ERR("Failed to read curve: no data read");
+        return -EACCES;
+    }
+    data[len - 1] = '\0';
+
+    ACCEL_TRACE_ENTER("nvs_load", dev_data->id, slot);
+    const int rc = curves_import(dev, slot, data, false);
+    ACCEL_TRACE_EXIT("nvs_load", dev_data->id, slot);
+    return rc < 0 ? rc : 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(accel_curves, ACCEL_CURVE_NVS_PREFIX, NULL, curves_settings_set, NULL, NULL);
+
+static void load_curves_work_handler(struct k_work *work) {
+    LOG_INF("Loading curves from NVS for all %d devices", num_dev);
+
+    // one pass over the whole subtree, the static handler dispatches each entry
+    settings_subsys_init();
+    const int rc = settings_load_subtree(ACCEL_CURVE_NVS_PREFIX);
+    if (rc != 0) {
+        LOG_ERR("Failed to load curves: %d", rc);
+    }
+}
+
+static int accel_curve_settings_init(void) {
+    if (num_dev == 0) {
+        return 0;
+    }
+
+    // settings are ready once the application level runs, load right away on the processor queue
+    k_work_init(&load_curves_work, load_curves_work_handler);
+    k_work_submit_to_queue(&accel_curve_wq, &load_curves_work);
+    return 0;
+}
+SYS_INIT(accel_curve_settings_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
 #if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_MONITOR)
 static bool g_accel_monitor = false;
 static bool g_accel_monitor_abs = false;
@@ -377,13 +662,14 @@ static void monitor_flush_work_fn(struct k_work *w) {
     }
 
     if (g_accel_monitor) {
-        k_work_reschedule(&g_monitor_flush_work, K_MSEC(CONFIG_ZMK_ACCEL_CURVE_MONITOR_FLUSH_INTERVAL_MS));
+        k_work_reschedule_for_queue(&accel_curve_wq, &g_monitor_flush_work, K_MSEC(CONFIG_ZMK_ACCEL_CURVE_MONITOR_FLUSH_INTERVAL_MS));
     }
 }
 
 static void monitor_init_work_once(void)
 {
     if (!g_monitor_work_initialized) {
+        accel_curve_wq_start();
         k_work_init_delayable(&g_monitor_flush_work, monitor_flush_work_fn);
         g_monitor_work_initialized = true;
     }
@@ -396,7 +682,7 @@ void accel_curve_monitoring_set(const bool enabled, const bool abs)
     g_accel_monitor = enabled;
     if (enabled) {
         g_accel_monitor_abs = abs;
-        k_work_reschedule(&g_monitor_flush_work, K_MSEC(CONFIG_ZMK_ACCEL_CURVE_MONITOR_FLUSH_INTERVAL_MS));
+        k_work_reschedule_for_queue(&accel_curve_wq, &g_monitor_flush_work, K_MSEC(CONFIG_ZMK_ACCEL_CURVE_MONITOR_FLUSH_INTERVAL_MS));
     } else {
         g_accel_monitor_last_event_ms = 0;
         g_accel_monitor_count = 0;
@@ -456,28 +742,36 @@ static inline void accel_monitor(const uint16_t code, const int32_t raw_val)
 
 #endif /* CONFIG_ZMK_ACCEL_CURVE_MONITOR */
 
-static float sample_coef(const struct accel_point *points, const uint32_t num_points,
-                         const int32_t abs_input_mult_int, const float input_mult_smooth) {
+static float sample_coef(const struct accel_lut *lut, const int32_t abs_input_mult_int, const float input_mult_smooth) {
+    const uint16_t *xs = lut->x;
+    const uint16_t *coefs = lut->coef;
+    const uint32_t num_points = lut->num_points;
+
     if (abs_input_mult_int <= 100) {
-        return points[0].y_coef;
+        return coefs[0] * ACCEL_COEF_SCALE;
     }
-    if (abs_input_mult_int >= points[num_points - 1].x) {
-        return points[num_points - 1].y_coef;
+
+    const int32_t key = abs_input_mult_int >> lut->x_shift;
+    const float key_smooth = lut->x_shift ? input_mult_smooth / (float)(1U << lut->x_shift) : input_mult_smooth;
+    if (key >= xs[num_points - 1]) {
+        return coefs[num_points - 1] * ACCEL_COEF_SCALE;
     }
-    if (abs_input_mult_int <= points[0].x) {
-        return points[0].y_coef;
+    if (key <= xs[0]) {
+        return coefs[0] * ACCEL_COEF_SCALE;
     }
     for (uint32_t i = 0; i < num_points - 1; i++) {
-        if (abs_input_mult_int >= points[i].x && abs_input_mult_int < points[i + 1].x) {
-            const struct accel_point *p0 = &points[i];
-            const struct accel_point *p1 = &points[i + 1];
-            const float t = (input_mult_smooth - (float)p0->x) / (float)(p1->x - p0->x);
-            return p0->y_coef + t * (p1->y_coef - p0->y_coef);
+        if (key >= xs[i] && key < xs[i + 1]) {
+            const float t = (key_smooth - (float)xs[i]) / (float)(xs[i + 1] - xs[i]);
+            return ((float)coefs[i] + t * (float)((int32_t)coefs[i + 1] - (int32_t)coefs[i])) * ACCEL_COEF_SCALE;
         }
     }
     return 1.0f;
 }
 
+static inline uint8_t accel_slot(const struct zip_accel_curve_config *config, const uint8_t event_idx) {
+    return config->curve_slots ? config->curve_slots[event_idx] : 0;
+}
+
 static inline bool accel_dz_zero(struct zip_accel_curve_data *data, const int32_t cooldown,
                                  const int64_t now, const int32_t value, const int32_t thres) {
     if (abs(value) > thres) {
@@ -490,120 +784,478 @@ static inline bool accel_dz_zero(struct zip_accel_curve_data *data, const int32_
     return true;
 }
 
-// ReSharper disable once CppParameterMayBeConstPtrOrRef
-static int sy_handle_event(const struct device *dev, struct input_event *event, const uint32_t p1,
-                           const uint32_t p2, struct zmk_input_processor_state *s) {
-    struct zip_accel_curve_data *data = dev->data;
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_CAPTURE)
+#define CAPTURE_ENTRIES CONFIG_ZMK_ACCEL_CURVE_CAPTURE_ENTRIES
+
+static uint32_t g_capture_buf[CAPTURE_ENTRIES];
+static uint32_t g_capture_len;
+static const struct device *g_capture_dev;
+static const struct device *g_capture_src;
+static uint32_t g_capture_last_cyc;
+static int64_t g_capture_end_ms;
+// frame being assembled, 0 while none is open
+static uint32_t g_capture_frame;
+
+static void capture_store(const uint32_t rec) {
+    g_capture_buf[g_capture_len % CAPTURE_ENTRIES] = rec;
+    g_capture_len++;
+}
+
+static void capture_push(const struct input_event *event, const uint8_t event_idx) {
+    const int64_t now = k_uptime_get();
+    if (now >= g_capture_end_ms) {
+        if (g_capture_frame != 0) {
+            capture_store(g_capture_frame);
+            g_capture_frame = 0;
+        }
+        g_capture_dev = NULL;
+        LOG_INF("Capture finished, %u record(s)", g_capture_len);
+        return;
+    }
+
+    if (g_capture_frame & ACCEL_CAPTURE_AXIS(event_idx, 0)) {
+        capture_store(g_capture_frame);
+        g_capture_frame = 0;
+    }
+
+    if (g_capture_frame == 0) {
+        const uint32_t cyc = k_cycle_get_32();
+        const uint32_t dt_us = g_capture_len == 0 ? 0 : k_cyc_to_us_floor32(cyc - g_capture_last_cyc);
+        uint32_t dt = dt_us / ACCEL_CAPTURE_DT_UNIT_US;
+        g_capture_last_cyc = cyc;
+        if (dt > ACCEL_CAPTURE_DT_MAX) {
+            capture_store(ACCEL_CAPTURE_GAP(dt_us));
+            dt = 0;
+        }
+        g_capture_frame = ACCEL_CAPTURE_FRAME(dt);
+    }
+
+    g_capture_frame |= ACCEL_CAPTURE_AXIS(event_idx, event->value);
+    if (event->sync) {
+        capture_store(g_capture_frame);
+        g_capture_frame = 0;
+    }
+}
+
+// Returns the i-th oldest record still held in the ring.
+static uint32_t capture_record_at(const uint32_t i) {
+    const uint32_t held = MIN(g_capture_len, CAPTURE_ENTRIES);
+    const uint32_t first = g_capture_len - held;
+    return g_capture_buf[(first + i) % CAPTURE_ENTRIES];
+}
+
+int accel_curve_capture_start(const struct device* dev, const uint32_t seconds) {
     const struct zip_accel_curve_config *config = dev->config;
+    if (config->event_codes_len > ACCEL_CAPTURE_MAX_CODES) {
+        return -ENOTSUP;
+    }
 
-    if (unlikely(!data->initialized)) {
+    g_capture_dev = NULL;
+    g_capture_len = 0;
+    g_capture_frame = 0;
+    g_capture_src = dev;
+    g_capture_end_ms = k_uptime_get() + (int64_t)seconds * 1000;
+    g_capture_dev = dev;
+    return 0;
+}
+
+void accel_curve_capture_stop(void) {
+    g_capture_dev = NULL;
+}
+
+bool accel_curve_capture_active(void) {
+    return g_capture_dev != NULL && k_uptime_get() < g_capture_end_ms;
+}
+
+uint32_t accel_curve_capture_count(void) {
+    return MIN(g_capture_len, CAPTURE_ENTRIES);
+}
+
+size_t accel_curve_capture_export(const size_t offset, uint8_t* buf, const size_t len) {
+    if (g_capture_src == NULL) {
         return 0;
     }
 
-    uint8_t event_idx = 0;
-    bool relevant = false;
+    const struct zip_accel_curve_config *config = g_capture_src->config;
+    struct accel_curve_capture_header hdr = {
+        .magic = ACCEL_CURVE_CAPTURE_MAGIC,
+        .version = ACCEL_CAPTURE_VERSION,
+        .event_codes_len = config->event_codes_len,
+        .count = accel_curve_capture_count(),
+        .overwritten = g_capture_len - accel_curve_capture_count(),
+    };
     for (uint8_t i = 0; i < config->event_codes_len; i++) {
-        if (event->code == config->event_codes[i]) {
-            relevant = true;
-            event_idx = i;
-            break;
+        hdr.event_codes[i] = config->event_codes[i];
+    }
+
+    const size_t total = sizeof(hdr) + hdr.count * sizeof(uint32_t);
+    size_t pos = offset;
+    size_t copied = 0;
+    while (copied < len && pos < total) {
+        if (pos < sizeof(hdr)) {
+            const size_t n = MIN(len - copied, sizeof(hdr) - pos);
+            memcpy(buf + copied, (const uint8_t *)&hdr + pos, n);
+            copied += n;
+            pos += n;
+        } else {
+            const size_t rel = pos - sizeof(hdr);
+            const uint32_t rec = capture_record_at(rel / sizeof(uint32_t));
+            const size_t n = MIN(len - copied, sizeof(uint32_t) - rel % sizeof(uint32_t));
+            memcpy(buf + copied, (const uint8_t *)&rec + rel % sizeof(uint32_t), n);
+            copied += n;
+            pos += n;
         }
     }
 
-    if (!relevant) {
-        return 0;
+    return copied;
+}
+#endif /* CONFIG_ZMK_ACCEL_CURVE_CAPTURE */
+
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_HISTOGRAM)
+#define HIST_BINS CONFIG_ZMK_ACCEL_CURVE_HISTOGRAM_BINS
+
+// velocity bin i holds speeds in [2^(i-1), 2^i), bin 0 holds zero
+static inline void hist_velocity(struct zip_accel_curve_data *data, const uint32_t speed) {
+    const uint32_t bin = speed == 0 ? 0 : 32 - __builtin_clz(speed);
+    data->hist.velocity[MIN(bin, HIST_BINS - 1)]++;
+}
+
+// coefficient bin i holds gains in [i, i+1) * CONFIG_ZMK_ACCEL_CURVE_HISTOGRAM_COEF_STEP / 100
+static inline void hist_coef(struct zip_accel_curve_data *data, const float coef) {
+    const uint32_t bin = (uint32_t)(coef * (100.0f / CONFIG_ZMK_ACCEL_CURVE_HISTOGRAM_COEF_STEP));
+    data->hist.coef[MIN(bin, HIST_BINS - 1)]++;
+}
+
+const struct accel_curve_histogram* accel_curve_hist_get(const struct device* dev) {
+    const struct zip_accel_curve_data *data = dev->data;
+    return &data->hist;
+}
+
+void accel_curve_hist_reset(const struct device* dev) {
+    struct zip_accel_curve_data *data = dev->data;
+    memset(&data->hist, 0, sizeof(data->hist));
+}
+
+int accel_curve_hist_export(const struct device* dev, uint8_t* buf, const size_t len) {
+    const struct zip_accel_curve_data *data = dev->data;
+    const struct accel_curve_hist_header hdr = {
+        .magic = ACCEL_CURVE_HIST_MAGIC,
+        .version = 1,
+        .bins = HIST_BINS,
+        .coef_step = CONFIG_ZMK_ACCEL_CURVE_HISTOGRAM_COEF_STEP,
+    };
+
+    const size_t total = sizeof(hdr) + sizeof(data->hist);
+    if (len < total) {
+        return -ENOMEM;
     }
 
-    if (config->points == 0 || data->num_points == 0 || !data->points || !data->remainders) {
-        return 0;
+    memcpy(buf, &hdr, sizeof(hdr));
+    memcpy(buf + sizeof(hdr), &data->hist, sizeof(data->hist));
+    return (int)total;
+}
+#else
+#define hist_velocity(data, speed) do { } while (0)
+#define hist_coef(data, coef)      do { } while (0)
+#endif /* CONFIG_ZMK_ACCEL_CURVE_HISTOGRAM */
+
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_GLIDE)
+#define GLIDE_AXES      2
+#define GLIDE_Q         8
+#define GLIDE_MIN_Q8(config)  (((int32_t)(config)->glide_min_speed << GLIDE_Q) / 100)
+#define GLIDE_FRIC_Q8(config) (((int32_t)(config)->glide_friction << GLIDE_Q) / 100)
+#define GLIDE_IDLE_TICKS \
+    DIV_ROUND_UP(CONFIG_ZMK_ACCEL_CURVE_GLIDE_IDLE_MS, CONFIG_ZMK_ACCEL_CURVE_GLIDE_TICK_MS)
+
+// Stops an ongoing glide, called for every real event before it is processed or buffered.
+static void glide_cancel(struct zip_accel_curve_data *data, const struct zip_accel_curve_config *config) {
+    if (!config->glide || !data->glide_active || unlikely(data->dry_run)) {
+        return;
     }
 
-    const int64_t dz_now = k_uptime_get();
-    zrc_cache_refresh_if_due((uint32_t) dz_now);
+    const k_spinlock_key_t key = k_spin_lock(&data->glide_lock);
+    data->glide_active = false;
+    memset(data->glide_v, 0, sizeof(data->glide_v));
+    memset(data->glide_pos, 0, sizeof(data->glide_pos));
+    k_spin_unlock(&data->glide_lock, key);
+}
+
+// Adds accelerated output to the current tick.
+static void glide_feed(struct zip_accel_curve_data *data, const struct zip_accel_curve_config *config,
+                       const uint8_t idx, const int32_t value, const struct device *input_dev) {
+    if (!config->glide || idx >= GLIDE_AXES || unlikely(data->dry_run)) {
+        return;
+    }
+
+    const k_spinlock_key_t key = k_spin_lock(&data->glide_lock);
+    data->glide_acc[idx] += value;
+    data->glide_input_dev = input_dev;
+    const bool arm = !data->glide_armed;
+    data->glide_armed = true;
+    k_spin_unlock(&data->glide_lock, key);
+
+    if (arm) {
+        k_work_schedule(&data->glide_work, K_MSEC(CONFIG_ZMK_ACCEL_CURVE_GLIDE_TICK_MS));
+    }
+}
+
+static inline int32_t glide_speed(const int32_t v[GLIDE_AXES]) {
+    return MAX(abs(v[0]), abs(v[1]));
+}
+
+// Proportional decay, then constant friction split between the axes so the direction is kept.
+static void glide_decay(const struct zip_accel_curve_config *config, int32_t v[GLIDE_AXES]) {
+    for (uint8_t i = 0; i < GLIDE_AXES; i++) {
+        v[i] = (int32_t)((int64_t)v[i] * config->glide_decay / 1000);
+    }
 
-    if (config->couple_axes && config->event_codes_len <= 2) {
-        if (!data->buffered_values || !data->buffered_present || !data->inject_pass) {
-            return 0;
+    const int32_t speed = glide_speed(v);
+    if (speed == 0) {
+        return;
+    }
+    for (uint8_t i = 0; i < GLIDE_AXES; i++) {
+        const int32_t fric = (int32_t)((int64_t)GLIDE_FRIC_Q8(config) * abs(v[i]) / speed);
+        if (abs(v[i]) <= fric) {
+            v[i] = 0;
+        } else {
+            v[i] -= v[i] > 0 ? fric : -fric;
         }
+    }
+}
 
-        if (data->inject_pass[event_idx]) {
-            data->inject_pass[event_idx] = false;
-            return 0;
+static void glide_work_handler(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct zip_accel_curve_data *data = CONTAINER_OF(dwork, struct zip_accel_curve_data, glide_work);
+    const struct zip_accel_curve_config *config = data->dev->config;
+
+    int32_t out[GLIDE_AXES] = {0};
+    k_spinlock_key_t key = k_spin_lock(&data->glide_lock);
+    if (!data->glide_active) {
+        if (data->glide_acc[0] != 0 || data->glide_acc[1] != 0) {
+            // output of this tick spread over the empty ticks before it, averaged with the previous speed
+            for (uint8_t i = 0; i < GLIDE_AXES; i++) {
+                const int32_t sample = (data->glide_acc[i] << GLIDE_Q) / (data->glide_empty_ticks + 1);
+                data->glide_v[i] = (data->glide_v[i] + sample) / 2;
+                data->glide_acc[i] = 0;
+            }
+            data->glide_empty_ticks = 0;
+        } else if (++data->glide_empty_ticks >= GLIDE_IDLE_TICKS) {
+            data->glide_empty_ticks = 0;
+            data->glide_active = glide_speed(data->glide_v) >= GLIDE_MIN_Q8(config);
+            if (!data->glide_active) {
+                memset(data->glide_v, 0, sizeof(data->glide_v));
+                data->glide_armed = false;
+            }
         }
+    }
 
-        int32_t in_val = event->value;
-        if (g_zrc_dz_enable && g_zrc_dz_before && accel_dz_zero(data, g_zrc_dz_cooldown, dz_now, in_val, g_zrc_dz_thres)) {
-            in_val = 0;
+    if (data->glide_active) {
+        for (uint8_t i = 0; i < GLIDE_AXES; i++) {
+            data->glide_pos[i] += data->glide_v[i];
+            out[i] = data->glide_pos[i] / (1 << GLIDE_Q);
+            data->glide_pos[i] -= out[i] * (1 << GLIDE_Q);
+        }
+        glide_decay(config, data->glide_v);
+        if (glide_speed(data->glide_v) < GLIDE_MIN_Q8(config)) {
+            data->glide_active = false;
+            data->glide_armed = false;
+            memset(data->glide_v, 0, sizeof(data->glide_v));
+            memset(data->glide_pos, 0, sizeof(data->glide_pos));
         }
-        data->buffered_values[event_idx] = in_val;
-        data->buffered_present[event_idx] = true;
+    }
+    const bool rearm = data->glide_armed;
+    const struct device *input_dev = data->glide_input_dev;
+    k_spin_unlock(&data->glide_lock, key);
+
+    // tagged like coupled output, so the processor passes it on without accelerating it again
+    const int8_t last_idx = out[1] != 0 ? 1 : (out[0] != 0 ? 0 : -1);
+    for (uint8_t i = 0; last_idx >= 0 && i < MIN(config->event_codes_len, GLIDE_AXES); i++) {
+        if (out[i] == 0) continue;
+        input_report(input_dev, ACCEL_CURVE_EV_INJECT, config->event_codes[i], out[i], i == (uint8_t)last_idx,
+                     K_NO_WAIT);
+    }
 
-#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_MONITOR)
-        accel_monitor(event->code, event->value);
+    if (rearm) {
+        k_work_schedule(dwork, K_MSEC(CONFIG_ZMK_ACCEL_CURVE_GLIDE_TICK_MS));
+    }
+}
+#else
+#define glide_cancel(data, config)                      do { } while (0)
+#define glide_feed(data, config, idx, value, input_dev) do { } while (0)
+#endif /* CONFIG_ZMK_ACCEL_CURVE_GLIDE */
+
+#if CONFIG_ZMK_ACCEL_CURVE_COUPLE_FLUSH_US > 0
+#define COUPLE_LOCK(data)        k_spin_lock(&(data)->couple_lock)
+#define COUPLE_UNLOCK(data, key) k_spin_unlock(&(data)->couple_lock, (key))
+#else
+#define COUPLE_LOCK(data)        ((k_spinlock_key_t){0})
+#define COUPLE_UNLOCK(data, key) ARG_UNUSED(key)
 #endif
 
-        if (!event->sync) {
-            event->value = 0;
-            return 0;
-        }
+// Computes the accelerated output for every buffered axis and empties the buffer.
+// Returns the index of the last axis to report, or -1 if there is nothing to emit.
+static int8_t accel_coupled_drain(struct zip_accel_curve_data *data, const struct zip_accel_curve_config *config,
+                                  const int64_t dz_now, int32_t out[2], bool present[2]) {
+    float effective[2] = {0};
+    float mag_sq = 0.0f;
+    for (uint8_t i = 0; i < config->event_codes_len; i++) {
+        present[i] = data->buffered_present[i];
+        if (!present[i]) continue;
+        const int32_t v = data->buffered_values[i];
+        const float av = (float)((v >= 0) ? v : -v);
+        effective[i] = av;
+        mag_sq += av * av;
+    }
 
-        float effective[2] = {0};
-        float mag_sq = 0.0f;
-        for (uint8_t i = 0; i < config->event_codes_len; i++) {
-            if (!data->buffered_present[i]) continue;
-            const int32_t v = data->buffered_values[i];
-            const float av = (float)((v >= 0) ? v : -v);
-            effective[i] = av;
-            mag_sq += av * av;
-        }
+    for (uint8_t i = 0; i < config->event_codes_len; i++) {
+        data->buffered_present[i] = false;
+    }
 
-        if (mag_sq <= 0.0f) {
-            for (uint8_t i = 0; i < config->event_codes_len; i++) {
-                data->buffered_present[i] = false;
-            }
-            event->value = 0;
-            return 0;
-        }
+    if (mag_sq <= 0.0f) {
+        return -1;
+    }
 
-        const float magnitude = sqrtf(mag_sq);
-        const int32_t abs_input_mult = magnitude * 100.0f;
-        const float input_mult = magnitude * 100.0f;
-        const float coef = sample_coef(data->points, data->num_points, abs_input_mult, input_mult);
+    const float magnitude = sqrtf(mag_sq);
+    const int32_t abs_input_mult = magnitude * 100.0f;
+    const float input_mult = magnitude * 100.0f;
 
-        int8_t last_idx = -1;
-        for (int16_t i = (int16_t)config->event_codes_len - 1; i >= 0; i--) {
-            if (data->buffered_present[i]) {
-                last_idx = (int8_t)i;
-                break;
-            }
+    // both axes share the vector magnitude, each reads the gain from its own slot
+    float coef[2] = {1.0f, 1.0f};
+    for (uint8_t i = 0; i < config->event_codes_len; i++) {
+        if (!present[i]) continue;
+        const uint8_t slot = accel_slot(config, i);
+        if (i > 0 && present[0] && slot == accel_slot(config, 0)) {
+            coef[i] = coef[0];
+            continue;
+        }
+        const struct accel_lut *lut = atomic_ptr_get(&data->luts[slot]);
+        if (lut != NULL) {
+            coef[i] = sample_coef(lut, abs_input_mult, input_mult);
         }
+    }
 
-        for (uint8_t i = 0; i < config->event_codes_len; i++) {
-            if (!data->buffered_present[i]) continue;
-            const int32_t v = data->buffered_values[i];
-            const int32_t scaleFactor = (v >= 0) ? 1 : -1;
-            const float result = effective[i] * coef + data->remainders[i];
-            const int32_t out_int = (int32_t) result;
-            data->remainders[i] = result - (float)out_int;
-            int32_t scaled = out_int * scaleFactor;
-            if (g_zrc_dz_enable && !g_zrc_dz_before && accel_dz_zero(data, g_zrc_dz_cooldown, dz_now, scaled, g_zrc_dz_thres)) {
-                scaled = 0;
-            }
+    // one sample per vector in both histograms, axes with their own slots contribute their mean gain
+    hist_velocity(data, (uint32_t)magnitude);
+    hist_coef(data, (present[0] && present[1]) ? (coef[0] + coef[1]) * 0.5f : (present[0] ? coef[0] : coef[1]));
 
-            data->inject_pass[i] = true;
-            input_report_rel(event->dev, config->event_codes[i], scaled,
-                             i == (uint8_t)last_idx, K_NO_WAIT);
+    int8_t last_idx = -1;
+    for (uint8_t i = 0; i < config->event_codes_len; i++) {
+        if (!present[i]) continue;
+        const int32_t v = data->buffered_values[i];
+        const int32_t scaleFactor = (v >= 0) ? 1 : -1;
+        const float result = effective[i] * coef[i] + data->remainders[i];
+        const int32_t out_int = (int32_t) result;
+        data->remainders[i] = result - (float)out_int;
+        int32_t scaled = out_int * scaleFactor;
+        if (g_zrc_dz_enable && !g_zrc_dz_before && accel_dz_zero(data, g_zrc_dz_cooldown, dz_now, scaled, g_zrc_dz_thres)) {
+            scaled = 0;
         }
+        out[i] = scaled;
+        last_idx = (int8_t)i;
+    }
 
-        for (uint8_t i = 0; i < config->event_codes_len; i++) {
-            data->buffered_present[i] = false;
-        }
+    return last_idx;
+}
+
+static void accel_coupled_report(struct zip_accel_curve_data *data, const struct zip_accel_curve_config *config,
+                                 const struct device *input_dev, const int32_t out[2], const bool present[2],
+                                 const int8_t last_idx) {
+    for (uint8_t i = 0; i < config->event_codes_len; i++) {
+        if (!present[i]) continue;
+        input_report(input_dev, ACCEL_CURVE_EV_INJECT, config->event_codes[i], out[i], i == (uint8_t)last_idx,
+                     K_NO_WAIT);
+        glide_feed(data, config, i, out[i], input_dev);
+    }
+}
+
+#if CONFIG_ZMK_ACCEL_CURVE_COUPLE_FLUSH_US > 0
+static void couple_flush_work_handler(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct zip_accel_curve_data *data = CONTAINER_OF(dwork, struct zip_accel_curve_data, couple_flush_work);
+    const struct zip_accel_curve_config *config = data->dev->config;
+
+    int32_t out[2] = {0};
+    bool present[2] = {false};
+    atomic_inc(&data->lut_readers);
+    const k_spinlock_key_t key = COUPLE_LOCK(data);
+    data->couple_flush_armed = false;
+    const int8_t last_idx = accel_coupled_drain(data, config, k_uptime_get(), out, present);
+    const struct device *input_dev = data->couple_input_dev;
+    COUPLE_UNLOCK(data, key);
+    atomic_dec(&data->lut_readers);
+
+    if (last_idx >= 0) {
+        LOG_DBG("Coupled axes flushed without sync");
+        accel_coupled_report(data, config, input_dev, out, present, last_idx);
+    }
+}
+#endif
+
+static int accel_handle_coupled(struct zip_accel_curve_data *data, const struct zip_accel_curve_config *config,
+                                struct input_event *event, const uint8_t event_idx, const int64_t dz_now) {
+    if (!data->buffered_values || !data->buffered_present) {
+        return 0;
+    }
+
+    int32_t in_val = event->value;
+    if (g_zrc_dz_enable && g_zrc_dz_before && accel_dz_zero(data, g_zrc_dz_cooldown, dz_now, in_val, g_zrc_dz_thres)) {
+        in_val = 0;
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_MONITOR)
+    if (likely(!data->dry_run)) {
+        accel_monitor(event->code, event->value);
+    }
+#endif
 
+    k_spinlock_key_t key = COUPLE_LOCK(data);
+    data->buffered_values[event_idx] = in_val;
+    data->buffered_present[event_idx] = true;
+
+    if (!event->sync) {
+#if CONFIG_ZMK_ACCEL_CURVE_COUPLE_FLUSH_US > 0
+        // bound the latency of a report whose sync never arrives
+        data->couple_input_dev = event->dev;
+        const bool arm = !data->couple_flush_armed && likely(!data->dry_run);
+        data->couple_flush_armed |= arm;
+        COUPLE_UNLOCK(data, key);
+        if (arm) {
+            k_work_schedule(&data->couple_flush_work, K_USEC(CONFIG_ZMK_ACCEL_CURVE_COUPLE_FLUSH_US));
+        }
+#else
+        COUPLE_UNLOCK(data, key);
+#endif
         event->value = 0;
-        event->sync = false;
         return 0;
     }
 
+#if CONFIG_ZMK_ACCEL_CURVE_COUPLE_FLUSH_US > 0
+    if (data->couple_flush_armed) {
+        data->couple_flush_armed = false;
+        k_work_cancel_delayable(&data->couple_flush_work);
+    }
+#endif
+
+    int32_t out[2] = {0};
+    bool present[2] = {false};
+    const int8_t last_idx = accel_coupled_drain(data, config, dz_now, out, present);
+    COUPLE_UNLOCK(data, key);
+
+    event->value = 0;
+    if (last_idx < 0) {
+        return 0;
+    }
+
+    if (likely(!data->dry_run)) {
+        accel_coupled_report(data, config, event->dev, out, present, last_idx);
+    }
+
+    event->sync = false;
+    return 0;
+}
+
+static int accel_handle_single(struct zip_accel_curve_data *data, const struct accel_lut *lut,
+                               struct input_event *event, const uint8_t event_idx, const int64_t dz_now) {
     const int32_t input_val = event->value;
     if (input_val == 0) {
         return 0;
@@ -620,10 +1272,14 @@ static int sy_handle_event(const struct device *dev, struct input_event *event,
     const float input_mult = (float)abs_input * 100.0f;
     const int32_t sign = (input_val >= 0) ? 1 : -1;
 
-    const float coef = sample_coef(data->points, data->num_points, abs_input_mult, input_mult);
+    const float coef = sample_coef(lut, abs_input_mult, input_mult);
+    hist_velocity(data, (uint32_t)abs_input);
+    hist_coef(data, coef);
 
 #if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_MONITOR)
-    accel_monitor(event->code, input_val);
+    if (likely(!data->dry_run)) {
+        accel_monitor(event->code, input_val);
+    }
 #endif
 
     const float result = (float)abs_input * coef + data->remainders[event_idx];
@@ -636,6 +1292,303 @@ static int sy_handle_event(const struct device *dev, struct input_event *event,
     return 0;
 }
 
+static inline int accel_process(const struct device *dev, struct input_event *event, const bool coupled) {
+    struct zip_accel_curve_data *data = dev->data;
+    const struct zip_accel_curve_config *config = dev->config;
+
+    uint8_t event_idx = 0;
+    bool relevant = false;
+    for (uint8_t i = 0; i < config->event_codes_len; i++) {
+        if (event->code == config->event_codes[i]) {
+            relevant = true;
+            event_idx = i;
+            break;
+        }
+    }
+
+    if (!relevant) {
+        return 0;
+    }
+
+    // output re-injected by the coupled or glide path is already processed, hand it on as plain relative motion
+    if (event->type == ACCEL_CURVE_EV_INJECT) {
+        event->type = INPUT_EV_REL;
+        return 0;
+    }
+
+    // raw input is captured even without a curve, pass-through devices are recorded as well
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_CAPTURE)
+    if (unlikely(g_capture_dev == dev)) {
+        capture_push(event, event_idx);
+    }
+#endif
+
+    if (unlikely(!data->initialized)) {
+        return 0;
+    }
+
+    if (config->points == 0 || !data->remainders) {
+        return 0;
+    }
+
+    const int64_t dz_now = k_uptime_get();
+    zrc_cache_refresh_if_due((uint32_t) dz_now);
+
+    // tables read below stay allocated until the count drops, see lut_slot_swap()
+    atomic_inc(&data->lut_readers);
+    glide_cancel(data, config);
+    int ret = 0;
+    if (coupled && config->event_codes_len <= 2) {
+        ret = accel_handle_coupled(data, config, event, event_idx, dz_now);
+    } else {
+        const struct accel_lut *lut = atomic_ptr_get(&data->luts[accel_slot(config, event_idx)]);
+        if (lut != NULL) {
+            ret = accel_handle_single(data, lut, event, event_idx, dz_now);
+            glide_feed(data, config, event_idx, event->value, event->dev);
+        }
+    }
+    atomic_dec(&data->lut_readers);
+    return ret;
+}
+
+// ReSharper disable once CppParameterMayBeConstPtrOrRef
+static int sy_handle_event(const struct device *dev, struct input_event *event, const uint32_t p1,
+                           const uint32_t p2, struct zmk_input_processor_state *s) {
+    const struct zip_accel_curve_config *config = dev->config;
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_TRACING)
+    const struct zip_accel_curve_data *data = dev->data;
+    const uint16_t code = event->code;
+    ACCEL_TRACE_ENTER("handle", data->id, code);
+    const int ret = accel_process(dev, event, config->couple_axes);
+    ACCEL_TRACE_EXIT("handle", data->id, code);
+    return ret;
+#else
+    return accel_process(dev, event, config->couple_axes);
+#endif
+}
+
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_BENCH)
+#define BENCH_BATCH 1024
+
+static int32_t bench_value(const enum accel_curve_bench_pattern pattern, const uint32_t i, const int32_t max_v) {
+    switch (pattern) {
+    case ACCEL_CURVE_BENCH_SLOW:
+        return 1 + (int32_t)(i & 1);
+    case ACCEL_CURVE_BENCH_FAST:
+        return max_v;
+    case ACCEL_CURVE_BENCH_SWEEP:
+    default: {
+        // triangle ramp 1..max_v..1 covering the whole table plus the clamp region
+        const uint32_t period = 2 * (uint32_t)max_v;
+        const uint32_t phase = i % period;
+        return 1 + (int32_t)(phase < (uint32_t)max_v ? phase : period - phase - 1);
+    }
+    }
+}
+
+static uint64_t bench_run(const struct device *fake, const uint32_t iterations, const enum accel_curve_bench_pattern pattern,
+                          const bool coupled, const int32_t max_v, uint32_t *events) {
+    const struct zip_accel_curve_config *config = fake->config;
+    const uint8_t axes = MIN(config->event_codes_len, 2);
+
+    uint64_t cycles = 0;
+    *events = 0;
+
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_CAPTURE)
+    if (pattern == ACCEL_CURVE_BENCH_CAPTURE) {
+        // each iteration replays the whole capture
+        const uint32_t count = accel_curve_capture_count();
+        for (uint32_t i = 0; i < iterations; i++) {
+            uint32_t replayed = 0;
+            timing_t t0 = timing_counter_get();
+            for (uint32_t r = 0; r < count; r++) {
+                const uint32_t rec = capture_record_at(r);
+                if (ACCEL_CAPTURE_IS_GAP(rec)) {
+                    continue;
+                }
+                // each frame is replayed as its present axes, with sync on the last one
+                for (uint8_t a = 0; a < MIN(config->event_codes_len, ACCEL_CAPTURE_MAX_CODES); a++) {
+                    if (!ACCEL_CAPTURE_PRESENT(rec, a)) continue;
+                    struct input_event ev = {
+                        .dev = NULL,
+                        .type = INPUT_EV_REL,
+                        .code = config->event_codes[a],
+                        .value = ACCEL_CAPTURE_VALUE(rec, a),
+                        .sync = a == ACCEL_CAPTURE_MAX_CODES - 1 || !ACCEL_CAPTURE_PRESENT(rec, a + 1),
+                    };
+                    accel_process(fake, &ev, coupled);
+                    replayed++;
+                }
+            }
+            timing_t t1 = timing_counter_get();
+            cycles += timing_cycles_get(&t0, &t1);
+            *events += replayed;
+            k_yield();
+        }
+        return cycles;
+    }
+#endif
+
+    // batches are timed as a whole, single events are below the resolution of slow counters
+    for (uint32_t i = 0; i < iterations;) {
+        const uint32_t start = i;
+        const uint32_t end = MIN(iterations, i + BENCH_BATCH);
+        timing_t t0 = timing_counter_get();
+        for (; i < end; i++) {
+            const int32_t v = bench_value(pattern, i, max_v);
+            for (uint8_t c = 0; c < axes; c++) {
+                struct input_event ev = {
+                    .dev = NULL,
+                    .type = INPUT_EV_REL,
+                    .code = config->event_codes[c],
+                    .value = (c == 0) ? v : -(v / 2),
+                    .sync = (c == axes - 1),
+                };
+                accel_process(fake, &ev, coupled);
+            }
+        }
+        timing_t t1 = timing_counter_get();
+        cycles += timing_cycles_get(&t0, &t1);
+        *events += (end - start) * axes;
+        k_yield();
+    }
+
+    return cycles;
+}
+
+// Resamples src into dst keeping every stride-th point plus the last one.
+static uint16_t bench_resample(const struct accel_lut *src, struct accel_lut *dst, const uint8_t stride) {
+    uint16_t n = 0;
+    for (uint16_t i = 0; i < src->num_points; i += stride) {
+        dst->x[n] = src->x[i];
+        dst->coef[n++] = src->coef[i];
+    }
+    if (n > 0 && dst->x[n - 1] != src->x[src->num_points - 1]) {
+        dst->x[n] = src->x[src->num_points - 1];
+        dst->coef[n++] = src->coef[src->num_points - 1];
+    }
+    dst->num_points = n;
+    dst->x_shift = src->x_shift;
+    return n;
+}
+
+int accel_curve_bench(const struct device *dev, const uint32_t iterations, const enum accel_curve_bench_pattern pattern,
+                      struct accel_curve_bench_result *results, const size_t max_results) {
+    if (dev == NULL || results == NULL || iterations == 0) {
+        return -EINVAL;
+    }
+
+    const struct zip_accel_curve_data *data = dev->data;
+    const struct zip_accel_curve_config *config = dev->config;
+
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_CAPTURE)
+    if (pattern == ACCEL_CURVE_BENCH_CAPTURE &&
+        (g_capture_src != dev || accel_curve_capture_active() || accel_curve_capture_count() == 0)) {
+        return -ENOENT;
+    }
+#endif
+
+    // the loaded tables are read throughout, keep imports from swapping them out
+    k_mutex_lock(&import_lock, K_FOREVER);
+    const struct accel_lut *src[ACCEL_CURVE_MAX_SLOTS] = { NULL };
+    for (uint8_t slot = 0; slot < data->num_slots; slot++) {
+        src[slot] = atomic_ptr_get(&data->luts[slot]);
+    }
+
+    // sizes are reported for the table of the first event code, or the first loaded one
+    uint8_t ref_slot = accel_slot(config, 0);
+    for (uint8_t slot = 0; slot < data->num_slots && (!src[ref_slot] || src[ref_slot]->num_points < 2); slot++) {
+        ref_slot = slot;
+    }
+    if (!data->initialized || !src[ref_slot] || src[ref_slot]->num_points < 2) {
+        k_mutex_unlock(&import_lock);
+        return -ENODATA;
+    }
+
+    // run against a private copy of the state so the real pipeline is never touched
+    struct zip_accel_curve_data tmp = {
+        .dev = dev,
+        .initialized = true,
+        .dry_run = true,
+        .num_slots = data->num_slots,
+        .remainders = calloc(config->event_codes_len, sizeof(float)),
+        .buffered_values = calloc(config->event_codes_len, sizeof(int32_t)),
+        .buffered_present = calloc(config->event_codes_len, sizeof(bool)),
+    };
+    const struct device fake = { .name = dev->name, .config = config, .data = &tmp };
+
+    int rc = 0;
+    struct accel_lut luts[ACCEL_CURVE_MAX_SLOTS] = { 0 };
+    bool alloc_ok = tmp.remainders && tmp.buffered_values && tmp.buffered_present;
+    for (uint8_t slot = 0; slot < data->num_slots && alloc_ok; slot++) {
+        if (src[slot] == NULL) continue;
+        luts[slot].x = malloc(sizeof(uint16_t) * 2 * src[slot]->num_points);
+        luts[slot].coef = luts[slot].x ? luts[slot].x + src[slot]->num_points : NULL;
+        alloc_ok = luts[slot].x != NULL;
+        atomic_ptr_set(&tmp.luts[slot], &luts[slot]);
+    }
+    if (!alloc_ok) {
+        rc = -ENOMEM;
+        goto out;
+    }
+
+    const struct accel_lut *ref = src[ref_slot];
+    const int32_t max_v = ((int32_t)ref->x[ref->num_points - 1] << ref->x_shift) / 100 + 1;
+
+    timing_init();
+    timing_start();
+
+    size_t count = 0;
+    uint16_t prev_size = 0;
+    static const uint8_t strides[] = { 4, 2, 1 };
+    for (size_t s = 0; s < ARRAY_SIZE(strides); s++) {
+        // coarser tables are resampled from the loaded ones
+        for (uint8_t slot = 0; slot < data->num_slots; slot++) {
+            if (luts[slot].x) {
+                bench_resample(src[slot], &luts[slot], strides[s]);
+            }
+        }
+
+        const uint16_t n = luts[ref_slot].num_points;
+        if (n < 2 || n == prev_size) {
+            continue;
+        }
+        prev_size = n;
+
+        for (uint8_t mode = 0; mode < 2; mode++) {
+            const bool coupled = (mode == 1);
+            if (coupled && config->event_codes_len > 2) {
+                continue;
+            }
+            if (count >= max_results) {
+                goto out;
+            }
+
+            memset(tmp.remainders, 0, sizeof(float) * config->event_codes_len);
+            memset(tmp.buffered_present, 0, sizeof(bool) * config->event_codes_len);
+
+            struct accel_curve_bench_result *r = &results[count++];
+            r->lut_points = n;
+            r->coupled = coupled;
+            r->cycles = bench_run(&fake, iterations, pattern, coupled, max_v, &r->events);
+            r->ns = timing_cycles_to_ns(r->cycles);
+            rc = (int)count;
+        }
+    }
+
+out:
+    timing_stop();
+    free(tmp.remainders);
+    free(tmp.buffered_values);
+    free(tmp.buffered_present);
+    for (uint8_t slot = 0; slot < data->num_slots; slot++) {
+        free(luts[slot].x);
+    }
+    k_mutex_unlock(&import_lock);
+    return rc;
+}
+#endif /* CONFIG_ZMK_ACCEL_CURVE_BENCH */
+
 static int sy_init(const struct device *dev) {
     if (!dev) {
         LOG_ERR("Unexpected NULL ptr");
@@ -646,6 +1599,15 @@ static int sy_init(const struct device *dev) {
     struct zip_accel_curve_data *data = dev->data;
     data->dev = dev;
 
+    data->num_slots = 1;
+    for (uint8_t i = 0; config->curve_slots && i < config->event_codes_len; i++) {
+        if (config->curve_slots[i] >= ACCEL_CURVE_MAX_SLOTS) {
+            LOG_ERR("Curve slot %d out of range for %s", config->curve_slots[i], config->device_name);
+            return -EINVAL;
+        }
+        data->num_slots = MAX(data->num_slots, config->curve_slots[i] + 1);
+    }
+
     for (uint8_t i = 0; i < num_dev; i++) {
         if (devices[i] == NULL) continue;
 
@@ -657,6 +1619,7 @@ static int sy_init(const struct device *dev) {
     }
 
     if (num_dev < DT_NUM_INST_STATUS_OKAY(DT_DRV_COMPAT)) {
+        data->id = num_dev;
         devices[num_dev] = dev;
         num_dev++;
     } else {
@@ -664,16 +1627,38 @@ static int sy_init(const struct device *dev) {
         return -EINVAL;
     }
     
-    if (!work_initialized) {
-        k_work_init_delayable(&load_curves_work, load_curves_work_handler);
-        work_initialized = true;
-    }
-    
-    k_work_cancel_delayable(&load_curves_work);
-    k_work_reschedule(&load_curves_work, K_MSEC(1350));
+    k_work_init(&data->save_work, save_curves_work_handler);
+#if CONFIG_ZMK_ACCEL_CURVE_COUPLE_FLUSH_US > 0
+    k_work_init_delayable(&data->couple_flush_work, couple_flush_work_handler);
+#endif
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_GLIDE)
+    k_work_init_delayable(&data->glide_work, glide_work_handler);
+#endif
+    accel_curve_wq_start();
     return 0;
 }
 
+size_t accel_curve_ram_usage(const struct device* dev) {
+    const struct zip_accel_curve_data *data = dev->data;
+    const struct zip_accel_curve_config *config = dev->config;
+
+    // shared tables are split evenly between their users
+    size_t total = sizeof(*data);
+    for (uint8_t slot = 0; slot < data->num_slots; slot++) {
+        const struct accel_lut_entry *e = data->lut_entries[slot];
+        if (e != NULL) {
+            total += (sizeof(*e) + sizeof(uint16_t) * 2 * e->points + sizeof(struct curve) * e->curve_count) / e->refcnt;
+        }
+    }
+    if (data->remainders) {
+        total += sizeof(float) * config->event_codes_len;
+    }
+    if (data->buffered_values) {
+        total += (sizeof(int32_t) + 2 * sizeof(bool)) * config->event_codes_len;
+    }
+    return total;
+}
+
 const struct device* device_by_name(const char* name) {
     if (name == NULL) return NULL;
     for (uint8_t i = 0; i < num_dev; i++) {
@@ -688,6 +1673,19 @@ const struct device* device_by_name(const char* name) {
     return NULL;
 }
 
+// A slot suffix must be a plain decimal number below num_slots.
+int accel_curve_parse_slot(const char* str, const uint8_t num_slots) {
+    if (str == NULL || !isdigit((unsigned char)str[0])) {
+        return -EINVAL;
+    }
+    char* end;
+    const unsigned long value = strtoul(str, &end, 10);
+    if (*end != '\0' || value >= num_slots) {
+        return -EINVAL;
+    }
+    return (int)value;
+}
+
 int list_devices(char*** names) {
     if (num_dev == 0) {
         return 0;
@@ -720,14 +1718,29 @@ int list_devices(char*** names) {
 
 static struct zmk_input_processor_driver_api sy_driver_api = { .handle_event = sy_handle_event };
 
+#define ACCEL_CURVE_SLOTS(n)                                                                      \
+    COND_CODE_1(DT_INST_NODE_HAS_PROP(n, curve_slots),                                            \
+                (BUILD_ASSERT(DT_INST_PROP_LEN(n, curve_slots) == DT_INST_PROP_LEN(n, event_codes),   \
+                              "curve-slots must have one entry per event code");                  \
+                 static const uint8_t curve_slots_##n[] = DT_INST_PROP(n, curve_slots);),         \
+                ())
+
 #define ACCEL_CURVE_INST(n)                                                                       \
+    ACCEL_CURVE_SLOTS(n)                                                                          \
+    BUILD_ASSERT(DT_INST_PROP_OR(n, glide_decay, 930) < 1000, "glide-decay must be below 1000");  \
     static struct zip_accel_curve_data data_##n = { 0 };                                          \
     static const struct zip_accel_curve_config config_##n = {                                     \
         .max_curves = DT_INST_PROP_OR(n, max_curves, 8),                                          \
         .points = DT_INST_PROP_OR(n, points, 64),                                                 \
+        .curve_slots = COND_CODE_1(DT_INST_NODE_HAS_PROP(n, curve_slots),                         \
+                                   (curve_slots_##n), (NULL)),                                    \
         .device_name = DT_INST_PROP_OR(n, device_name, "unknown"),                                \
         .event_codes_len = DT_INST_PROP_LEN(n, event_codes),                                      \
         .couple_axes = DT_INST_PROP_OR(n, couple_axes, false),                                    \
+        .glide = DT_INST_PROP_OR(n, glide, false),                                                \
+        .glide_decay = DT_INST_PROP_OR(n, glide_decay, 930),                                      \
+        .glide_friction = DT_INST_PROP_OR(n, glide_friction, 5),                                  \
+        .glide_min_speed = DT_INST_PROP_OR(n, glide_min_speed, 100),                              \
         .event_codes = DT_INST_PROP(n, event_codes)                                               \
     };                                                                                            \
     DEVICE_DT_INST_DEFINE(n, &sy_init, NULL, &data_##n, &config_##n, POST_KERNEL,                 \
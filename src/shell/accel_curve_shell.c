@@ -6,6 +6,15 @@
 #include <zephyr/settings/settings.h>
 #include "drivers/behavior_accel_curves_runtime.h"
 
+#if (IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_HISTOGRAM) || IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_CAPTURE)) && \
+    IS_ENABLED(CONFIG_ZMK_BLE_SHELL_DATA_CHANNEL)
+#include <zmk_ble_shell/data_channel.h>
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_BENCH)
+#include <zephyr/timing/timing.h>
+#endif
+
 #define DT_DRV_COMPAT zmk_curve_shell
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
@@ -16,6 +25,29 @@ do { \
     shell_print((_sh), _fmt, ##__VA_ARGS__); \
 } while (0)
 
+// Accepts "name" or "name/slot", a slot suffix that is not a plain number is rejected.
+static const struct device* device_by_target(const char* target, uint8_t* slot) {
+    char name[24];
+    const char* sep = strchr(target, '/');
+    const size_t len = sep ? (size_t)(sep - target) : strlen(target);
+    if (len >= sizeof(name)) {
+        return NULL;
+    }
+
+    *slot = 0;
+    if (sep) {
+        const int value = accel_curve_parse_slot(sep + 1, ACCEL_CURVE_MAX_SLOTS);
+        if (value < 0) {
+            return NULL;
+        }
+        *slot = (uint8_t)value;
+    }
+
+    memcpy(name, target, len);
+    name[len] = '\0';
+    return device_by_name(name);
+}
+
 static int cmd_status(const struct shell *sh, const size_t argc, char **argv) {
     if (strcmp(argv[0], "status") == 0 && argc == 1) {
         char** names = NULL;
@@ -33,7 +65,9 @@ static int cmd_status(const struct shell *sh, const size_t argc, char **argv) {
                     break;
                 }
                 const struct zip_accel_curve_config *config = dev->config;
-                shprint(sh, "  %s (up to %d curve(s), %d point(s) interpolation)", names[i], config->max_curves, config->points);
+                const struct zip_accel_curve_data *data = dev->data;
+                shprint(sh, "  %s (up to %d curve(s), %d point(s) interpolation, %d slot(s), %u bytes RAM)", names[i],
+                        config->max_curves, config->points, data->num_slots, (unsigned)accel_curve_ram_usage(dev));
             }
 
             for (int i = 0; i < available; i++) {
@@ -55,22 +89,37 @@ static int cmd_status(const struct shell *sh, const size_t argc, char **argv) {
 
 static int cmd_destroy(const struct shell *sh, const size_t argc, char **argv) {
     if (argc < 2) {
-        shprint(sh, "Usage: curve destroy [name]");
+        shprint(sh, "Usage: curve destroy [name[/slot]]");
         return -EINVAL;
     }
 
-    const struct device* dev = device_by_name(argv[1]);
+    uint8_t slot = 0;
+    const struct device* dev = device_by_target(argv[1], &slot);
     if (dev == NULL) {
-        shprint(sh, "Device not found.");
+        shprint(sh, "Device or slot not found.");
         return -EINVAL;
     }
 
-    char buf[24];
-    snprintf(buf, sizeof(buf), "%s/%s", ACCEL_CURVE_NVS_PREFIX, argv[1]);
-    const int err = settings_delete(buf);
-    if (err < 0) {
-        shprint(sh, "Could not delete settings.");
-        return err;
+    const struct zip_accel_curve_config *config = dev->config;
+    const struct zip_accel_curve_data *data = dev->data;
+    const bool all = strchr(argv[1], '/') == NULL;
+    if (slot >= data->num_slots) {
+        shprint(sh, "Device or slot not found.");
+        return -EINVAL;
+    }
+    for (uint8_t i = all ? 0 : slot; i < (all ? data->num_slots : slot + 1); i++) {
+        char buf[32];
+        if (i == 0) {
+            snprintf(buf, sizeof(buf), "%s/%s", ACCEL_CURVE_NVS_PREFIX, config->device_name);
+        } else {
+            snprintf(buf, sizeof(buf), "%s/%s/%u", ACCEL_CURVE_NVS_PREFIX, config->device_name, i);
+        }
+
+        const int err = settings_delete(buf);
+        if (err < 0) {
+            shprint(sh, "Could not delete settings.");
+            return err;
+        }
     }
 
     shprint(sh, "Success.");
@@ -79,13 +128,14 @@ static int cmd_destroy(const struct shell *sh, const size_t argc, char **argv) {
 
 static int cmd_set(const struct shell *sh, const size_t argc, char **argv) {
     if (argc < 3) {
-        shprint(sh, "Usage: curve set [name] [...values...]");
+        shprint(sh, "Usage: curve set [name[/slot]] [...values...]");
         return -EINVAL;
     }
 
-    const struct device* dev = device_by_name(argv[1]);
+    uint8_t slot = 0;
+    const struct device* dev = device_by_target(argv[1], &slot);
     if (dev == NULL) {
-        shprint(sh, "Device not found.");
+        shprint(sh, "Device or slot not found.");
         return -EINVAL;
     }
 
@@ -112,7 +162,7 @@ static int cmd_set(const struct shell *sh, const size_t argc, char **argv) {
         }
     }
 
-    const int ret = data_import(dev, datastring);
+    const int ret = data_import(dev, slot, datastring);
     free(datastring);
 
     if (ret == 0) {
@@ -144,6 +194,189 @@ static int cmd_monitor(const struct shell *sh, const size_t argc, char **argv) {
 }
 #endif /* CONFIG_ZMK_ACCEL_CURVE_MONITOR */
 
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_HISTOGRAM)
+static int cmd_hist(const struct shell *sh, const size_t argc, char **argv) {
+    if (argc < 2) {
+        shprint(sh, "Usage: curve hist [name] [reset|raw]");
+        return -EINVAL;
+    }
+
+    const struct device* dev = device_by_name(argv[1]);
+    if (dev == NULL) {
+        shprint(sh, "Device not found.");
+        return -EINVAL;
+    }
+
+    if (argc >= 3 && strcmp(argv[2], "reset") == 0) {
+        accel_curve_hist_reset(dev);
+        shprint(sh, "Done.");
+        return 0;
+    }
+
+    if (argc >= 3 && strcmp(argv[2], "raw") == 0) {
+        uint8_t blob[sizeof(struct accel_curve_hist_header) + sizeof(struct accel_curve_histogram)];
+        const int len = accel_curve_hist_export(dev, blob, sizeof(blob));
+        if (len < 0) {
+            return len;
+        }
+
+        shell_hexdump(sh, blob, len);
+#if IS_ENABLED(CONFIG_ZMK_BLE_SHELL_DATA_CHANNEL)
+        zmk_ble_shell_data_write(blob, len);
+#endif
+        return 0;
+    }
+
+    if (argc >= 3) {
+        shprint(sh, "Usage: curve hist [name] [reset|raw]");
+        return -EINVAL;
+    }
+
+    const struct accel_curve_histogram *hist = accel_curve_hist_get(dev);
+    const uint32_t step = CONFIG_ZMK_ACCEL_CURVE_HISTOGRAM_COEF_STEP;
+    shprint(sh, "Velocity (counts/report):");
+    for (uint32_t i = 0; i < CONFIG_ZMK_ACCEL_CURVE_HISTOGRAM_BINS; i++) {
+        const uint32_t lo = i == 0 ? 0 : BIT(i - 1);
+        shprint(sh, "  %6u%s %u", lo, i == CONFIG_ZMK_ACCEL_CURVE_HISTOGRAM_BINS - 1 ? "+" : " ", hist->velocity[i]);
+    }
+
+    shprint(sh, "Gain:");
+    for (uint32_t i = 0; i < CONFIG_ZMK_ACCEL_CURVE_HISTOGRAM_BINS; i++) {
+        const uint32_t lo = i * step;
+        shprint(sh, "  %3u.%02ux%s %u", lo / 100, lo % 100, i == CONFIG_ZMK_ACCEL_CURVE_HISTOGRAM_BINS - 1 ? "+" : " ",
+                hist->coef[i]);
+    }
+
+    return 0;
+}
+#endif /* CONFIG_ZMK_ACCEL_CURVE_HISTOGRAM */
+
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_CAPTURE)
+static int cmd_record(const struct shell *sh, const size_t argc, char **argv) {
+    if (argc == 2 && strcmp(argv[1], "stop") == 0) {
+        accel_curve_capture_stop();
+        shprint(sh, "Stopped, %u record(s) captured.", accel_curve_capture_count());
+        return 0;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "status") == 0) {
+        shprint(sh, "%s, %u record(s) captured.", accel_curve_capture_active() ? "Recording" : "Idle",
+                accel_curve_capture_count());
+        return 0;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "dump") == 0) {
+        accel_curve_capture_stop();
+
+        uint8_t chunk[64];
+        size_t offset = 0;
+        size_t n;
+        while ((n = accel_curve_capture_export(offset, chunk, sizeof(chunk))) > 0) {
+            shell_hexdump(sh, chunk, n);
+#if IS_ENABLED(CONFIG_ZMK_BLE_SHELL_DATA_CHANNEL)
+            zmk_ble_shell_data_write(chunk, n);
+#endif
+            offset += n;
+        }
+
+        shprint(sh, "%u byte(s).", (unsigned)offset);
+        return 0;
+    }
+
+    if (argc < 3) {
+        shprint(sh, "Usage: curve record [name] [seconds] | stop | status | dump");
+        return -EINVAL;
+    }
+
+    const struct device* dev = device_by_name(argv[1]);
+    if (dev == NULL) {
+        shprint(sh, "Device not found.");
+        return -EINVAL;
+    }
+
+    const uint32_t seconds = strtoul(argv[2], NULL, 10);
+    if (seconds == 0) {
+        shprint(sh, "Invalid duration.");
+        return -EINVAL;
+    }
+
+    const int rc = accel_curve_capture_start(dev, seconds);
+    if (rc != 0) {
+        shprint(sh, "Could not start capture: %d", rc);
+        return rc;
+    }
+
+    shprint(sh, "Recording %s for %u s.", argv[1], seconds);
+    return 0;
+}
+#endif /* CONFIG_ZMK_ACCEL_CURVE_CAPTURE */
+
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_BENCH)
+static int cmd_bench(const struct shell *sh, const size_t argc, char **argv) {
+    if (argc < 2) {
+        shprint(sh, "Usage: curve bench [name] [iterations] [sweep|slow|fast|capture]");
+        return -EINVAL;
+    }
+
+    const struct device* dev = device_by_name(argv[1]);
+    if (dev == NULL) {
+        shprint(sh, "Device not found.");
+        return -EINVAL;
+    }
+
+    const uint32_t iterations = argc >= 3 ? strtoul(argv[2], NULL, 10) : 10000;
+    if (iterations == 0) {
+        shprint(sh, "Invalid iteration count.");
+        return -EINVAL;
+    }
+
+    enum accel_curve_bench_pattern pattern = ACCEL_CURVE_BENCH_SWEEP;
+    if (argc >= 4) {
+        if (strcmp(argv[3], "sweep") == 0) {
+            pattern = ACCEL_CURVE_BENCH_SWEEP;
+        } else if (strcmp(argv[3], "slow") == 0) {
+            pattern = ACCEL_CURVE_BENCH_SLOW;
+        } else if (strcmp(argv[3], "fast") == 0) {
+            pattern = ACCEL_CURVE_BENCH_FAST;
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_CAPTURE)
+        } else if (strcmp(argv[3], "capture") == 0) {
+            pattern = ACCEL_CURVE_BENCH_CAPTURE;
+#endif
+        } else {
+            shprint(sh, "Unknown pattern: %s", argv[3]);
+            return -EINVAL;
+        }
+    }
+
+    struct accel_curve_bench_result results[ACCEL_CURVE_BENCH_MAX_RESULTS];
+    const int count = accel_curve_bench(dev, iterations, pattern, results, ARRAY_SIZE(results));
+    if (count == -ENODATA) {
+        shprint(sh, "No curve loaded.");
+        return count;
+    }
+    if (count == -ENOENT) {
+        shprint(sh, "No finished capture for this device.");
+        return count;
+    }
+    if (count < 0) {
+        shprint(sh, "Benchmark failed: %d", count);
+        return count;
+    }
+
+    shprint(sh, "%s, %u iteration(s), %u MHz timing counter:", argv[1], iterations, timing_freq_get_mhz());
+    for (int i = 0; i < count; i++) {
+        const struct accel_curve_bench_result *r = &results[i];
+        const uint64_t per_event_x100 = r->events ? (r->cycles * 100) / r->events : 0;
+        const uint64_t ns = r->events ? r->ns / r->events : 0;
+        shprint(sh, "  %3u point(s), %-9s %u.%02u cycles/event (%u ns)", r->lut_points,
+                r->coupled ? "coupled:" : "single:", (uint32_t)(per_event_x100 / 100),
+                (uint32_t)(per_event_x100 % 100), (uint32_t)ns);
+    }
+
+    return 0;
+}
+#endif /* CONFIG_ZMK_ACCEL_CURVE_BENCH */
+
 SHELL_STATIC_SUBCMD_SET_CREATE(sub_curve,
     SHELL_CMD(status, NULL, "Get current status", cmd_status),
     SHELL_CMD(dump, NULL, "Dump curve(s)", cmd_status),
@@ -151,6 +384,15 @@ SHELL_STATIC_SUBCMD_SET_CREATE(sub_curve,
     SHELL_CMD(destroy, NULL, "Clear device", cmd_destroy),
 #if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_MONITOR)
     SHELL_CMD(monitor, NULL, "Monitor raw values", cmd_monitor),
+#endif
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_HISTOGRAM)
+    SHELL_CMD(hist, NULL, "Velocity and gain histograms", cmd_hist),
+#endif
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_CAPTURE)
+    SHELL_CMD(record, NULL, "Capture raw input", cmd_record),
+#endif
+#if IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_BENCH)
+    SHELL_CMD(bench, NULL, "Benchmark processing path", cmd_bench),
 #endif
     SHELL_SUBCMD_SET_END
 );
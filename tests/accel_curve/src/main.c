@@ -0,0 +1,322 @@
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/input/input.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/timing/timing.h>
+#include <zephyr/ztest.h>
+#include <drivers/input_processor.h>
+#include <drivers/behavior_accel_curves_runtime.h>
+
+LOG_MODULE_REGISTER(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+// golden data below is only valid for this configuration, prj.conf pins it
+BUILD_ASSERT(CONFIG_ZMK_ACCEL_CURVE_COEF_FRAC_BITS == 12, "golden tables are Q12");
+BUILD_ASSERT(!IS_ENABLED(CONFIG_ZMK_ACCEL_CURVE_DEAD_ZONE), "golden outputs assume no dead zone");
+
+#define GOLDEN_POINTS 32
+#define RAMP_EVENTS   4096
+#define CYCLE_EVENTS  4096
+#define CYCLE_BATCHES 5
+// one curve unit (x100) plus one LSB, covers FMA contraction in the Bezier evaluation
+#define TABLE_COEF_TOL (4096 / 100 + 1)
+
+// Generated off target from a host build of the curve parser, table builder and event paths.
+// coef holds the raw Q12 table values, round(y * 4096 / 100) of the curve y at each point, so the
+// conversion under test never computes its own expectation. gain_7 and gain_7_3 are the gains
+// interpolated by hand from x and coef at speed 7 and at the vector (7, -3).
+struct golden {
+    const char *name;
+    const char *curve;
+    uint8_t num_points;
+    uint8_t x_shift;
+    uint16_t x[GOLDEN_POINTS];
+    uint16_t coef[GOLDEN_POINTS];
+    int32_t single;
+    int32_t coupled[2];
+    double gain_7;
+    double gain_7_3;
+};
+
+static const struct golden golden[] = {
+    {
+        .name = "s-curve",
+        .curve = "0 100 500 150 100 100 400 130 500 150 2000 300 700 160 1800 290",
+        .num_points = 32,
+        .x_shift = 0,
+        .x = {
+            115, 151, 190, 230, 269, 309, 348, 384, 419, 450, 477, 500, 500, 538, 590, 654, 729,
+            812, 902, 997, 1096, 1198, 1301, 1403, 1502, 1597, 1687, 1770, 1845, 1909, 1961, 2000
+        },
+        .coef = {
+            2867, 3318, 3768, 4137, 4506, 4792, 5079, 5325, 5571, 5775, 5939, 6144, 6144, 6226,
+            6390, 6636, 6963, 7291, 7660, 8069, 8520, 8970, 9421, 9871, 10322, 10732, 11100, 11428,
+            11756, 12001, 12165, 12288
+        },
+        .single = 108964,
+        .coupled = { 113827, -54640 },
+        .gain_7 = 1.669082031,
+        .gain_7_3 = 1.731381673,
+    },
+    {
+        .name = "linear",
+        .curve = "0 100 1000 200 300 130 700 170",
+        .num_points = 28,
+        .x_shift = 0,
+        .x = {
+            120, 152, 183, 216, 248, 281, 314, 348, 381, 415, 449, 483, 516, 550, 584, 618, 651,
+            685, 718, 751, 783, 816, 847, 879, 910, 940, 970, 1000
+        },
+        .coef = {
+            2130, 2540, 2908, 3236, 3604, 3932, 4219, 4506, 4792, 5038, 5325, 5530, 5775, 5980,
+            6185, 6390, 6595, 6758, 6922, 7086, 7250, 7373, 7537, 7660, 7782, 7946, 8069, 8192
+        },
+        .single = 41270,
+        .coupled = { 42639, -19695 },
+        .gain_7 = 1.668101918,
+        .gain_7_3 = 1.743215045,
+    },
+    {
+        .name = "steep",
+        .curve = "0 100 300 100 100 100 200 100 300 100 800 400 500 100 600 400 800 400 3000 800 1500 600 2500 800",
+        .num_points = 32,
+        .x_shift = 0,
+        .x = {
+            100, 133, 166, 200, 233, 266, 300, 300, 363, 420, 474, 524, 575, 625, 679, 736, 800,
+            800, 954, 1116, 1283, 1454, 1628, 1802, 1975, 2144, 2309, 2467, 2617, 2757, 2885, 3000
+        },
+        .coef = {
+            2990, 3441, 3768, 3932, 4055, 4055, 4096, 4096, 4506, 5612, 7250, 9216, 11223, 13189,
+            14828, 15933, 16384, 16384, 18104, 19866, 21545, 23183, 24781, 26255, 27648, 28877,
+            29983, 30925, 31703, 32276, 32645, 32768
+        },
+        .single = 435302,
+        .coupled = { 452101, -220123 },
+        .gain_7 = 3.719508121,
+        .gain_7_3 = 3.933896547,
+    },
+    {
+        .name = "wide",
+        .curve = "0 100 200000 250 50000 100 150000 250",
+        .num_points = 31,
+        .x_shift = 2,
+        .x = {
+            1247, 2568, 3957, 5409, 6919, 8481, 10091, 11745, 13436, 15159, 16911, 18685, 20476,
+            22281, 24092, 25907, 27718, 29523, 31314, 33088, 34840, 36563, 38254, 39908, 41518,
+            43080, 44590, 46042, 47431, 48752, 50000
+        },
+        .coef = {
+            737, 1147, 1516, 1925, 2335, 2744, 3154, 3604, 4014, 4424, 4874, 5284, 5693, 6103,
+            6472, 6881, 7250, 7619, 7946, 8274, 8602, 8888, 9134, 9380, 9585, 9789, 9912, 10035,
+            10158, 10199, 10240
+        },
+        .single = 7801797,
+        .coupled = { 8244338, -4120527 },
+        .gain_7 = 0.179931641,
+        .gain_7_3 = 0.179931641,
+    },
+};
+
+static const struct device *const single_dev = DEVICE_DT_GET(DT_NODELABEL(accel_single));
+static const struct device *const coupled_dev = DEVICE_DT_GET(DT_NODELABEL(accel_coupled));
+
+static uint16_t golden_x[GOLDEN_POINTS];
+static uint16_t golden_coef[GOLDEN_POINTS];
+static struct accel_lut golden_lut = { .x = golden_x, .coef = golden_coef };
+
+// sums of the output the coupled path re-injects, per axis
+static int64_t injected[2];
+
+static void injected_cb(struct input_event *evt, void *user_data) {
+    ARG_UNUSED(user_data);
+    if (evt->type != ACCEL_CURVE_EV_INJECT) {
+        return;
+    }
+    if (evt->code == INPUT_REL_X) {
+        injected[0] += evt->value;
+    } else if (evt->code == INPUT_REL_Y) {
+        injected[1] += evt->value;
+    }
+}
+INPUT_CALLBACK_DEFINE(NULL, injected_cb, NULL);
+
+static int32_t feed(const struct device *dev, const uint16_t code, const int32_t value, const bool sync) {
+    struct input_event ev = { .type = INPUT_EV_REL, .code = code, .value = value, .sync = sync };
+    zmk_input_processor_handle_event(dev, &ev, 0, 0, NULL);
+    return ev.value;
+}
+
+// Imports the curve, then points slot 0 at the golden table so Bezier rounding can't leak into outputs.
+static void load_golden(const struct device *dev, const struct golden *g) {
+    struct zip_accel_curve_data *data = dev->data;
+    zassert_true(data_import(dev, 0, g->curve) > 0, "%s: import failed", g->name);
+
+    memcpy(golden_x, g->x, sizeof(golden_x));
+    memcpy(golden_coef, g->coef, sizeof(golden_coef));
+    golden_lut.num_points = g->num_points;
+    golden_lut.x_shift = g->x_shift;
+    atomic_ptr_set(&data->luts[0], &golden_lut);
+    memset(data->remainders, 0, sizeof(float) * 2);
+    memset(injected, 0, sizeof(injected));
+}
+
+static inline int32_t ramp_max(const struct golden *g) {
+    return ((int32_t)g->x[g->num_points - 1] << g->x_shift) / 100 + 1;
+}
+
+static inline int64_t drift_tol(const int64_t expected) {
+    // float rounding of the product and remainder stays well under 1 ppm
+    return 2 + llabs(expected) / (1 << 20);
+}
+
+static void *accel_curve_setup(void) {
+    zassert_true(device_is_ready(single_dev), "uncoupled instance not ready");
+    zassert_true(device_is_ready(coupled_dev), "coupled instance not ready");
+    return NULL;
+}
+
+ZTEST_SUITE(accel_curve, NULL, accel_curve_setup, NULL, NULL, NULL);
+
+ZTEST(accel_curve, test_table) {
+    const struct zip_accel_curve_data *data = single_dev->data;
+    for (size_t c = 0; c < ARRAY_SIZE(golden); c++) {
+        const struct golden *g = &golden[c];
+        zassert_true(data_import(single_dev, 0, g->curve) > 0, "%s: import failed", g->name);
+
+        const struct accel_lut *lut = atomic_ptr_get(&data->luts[0]);
+        zassert_not_null(lut, "%s: no table", g->name);
+        zassert_equal(lut->num_points, g->num_points, "%s: %u points", g->name, lut->num_points);
+        zassert_equal(lut->x_shift, g->x_shift, "%s: shift %u", g->name, lut->x_shift);
+        for (uint8_t i = 0; i < g->num_points; i++) {
+            zassert_within(lut->x[i], g->x[i], 1, "%s: x[%u] = %u", g->name, i, lut->x[i]);
+            zassert_within(lut->coef[i], g->coef[i], TABLE_COEF_TOL, "%s: coef[%u] = %u", g->name, i,
+                           lut->coef[i]);
+        }
+    }
+}
+
+ZTEST(accel_curve, test_ramp_single) {
+    for (size_t c = 0; c < ARRAY_SIZE(golden); c++) {
+        const struct golden *g = &golden[c];
+        load_golden(single_dev, g);
+
+        const int32_t max_v = ramp_max(g);
+        int64_t total = 0;
+        for (uint32_t i = 0; i < RAMP_EVENTS; i++) {
+            total += feed(single_dev, INPUT_REL_X, 1 + (int32_t)(i % max_v), true);
+        }
+        zassert_within(total, g->single, 1, "%s: got %lld", g->name, (long long)total);
+    }
+}
+
+ZTEST(accel_curve, test_ramp_coupled) {
+    for (size_t c = 0; c < ARRAY_SIZE(golden); c++) {
+        const struct golden *g = &golden[c];
+        load_golden(coupled_dev, g);
+
+        const int32_t max_v = ramp_max(g);
+        for (uint32_t i = 0; i < RAMP_EVENTS; i++) {
+            const int32_t v = 1 + (int32_t)(i % max_v);
+            feed(coupled_dev, INPUT_REL_X, v, false);
+            feed(coupled_dev, INPUT_REL_Y, -(v / 2), true);
+        }
+        zassert_within(injected[0], g->coupled[0], 1, "%s: x got %lld", g->name, (long long)injected[0]);
+        zassert_within(injected[1], g->coupled[1], 1, "%s: y got %lld", g->name, (long long)injected[1]);
+    }
+}
+
+// remainder accumulation must not drift from the exact product over many events
+ZTEST(accel_curve, test_drift_single) {
+    for (size_t c = 0; c < ARRAY_SIZE(golden); c++) {
+        const struct golden *g = &golden[c];
+        load_golden(single_dev, g);
+
+        int64_t total = 0;
+        for (uint32_t i = 0; i < CONFIG_ACCEL_CURVE_TEST_DRIFT_EVENTS; i++) {
+            total += feed(single_dev, INPUT_REL_X, 7, true);
+        }
+        const int64_t expected = (int64_t)((double)CONFIG_ACCEL_CURVE_TEST_DRIFT_EVENTS * 7.0 * g->gain_7);
+        zassert_within(total, expected, drift_tol(expected), "%s: got %lld, expected %lld", g->name,
+                       (long long)total, (long long)expected);
+    }
+}
+
+ZTEST(accel_curve, test_drift_coupled) {
+    for (size_t c = 0; c < ARRAY_SIZE(golden); c++) {
+        const struct golden *g = &golden[c];
+        load_golden(coupled_dev, g);
+
+        for (uint32_t i = 0; i < CONFIG_ACCEL_CURVE_TEST_DRIFT_EVENTS; i++) {
+            feed(coupled_dev, INPUT_REL_X, 7, false);
+            feed(coupled_dev, INPUT_REL_Y, -3, true);
+        }
+        // |x| + |y| of the vector is 10
+        const int64_t total = injected[0] - injected[1];
+        const int64_t expected = (int64_t)((double)CONFIG_ACCEL_CURVE_TEST_DRIFT_EVENTS * 10.0 * g->gain_7_3);
+        zassert_within(total, expected, 2 * drift_tol(expected), "%s: got %lld, expected %lld", g->name,
+                       (long long)total, (long long)expected);
+    }
+}
+
+// Cycles per event on the nRF52840 DK (DWT counter, 64 MHz), indexed like golden[], as
+// { uncoupled, coupled }. Store the values test_cycles prints; 0 marks a missing measurement and
+// fails the check, so a ceiling is never guessed. Re-measure whenever the event path changes.
+static const uint32_t cycle_baseline[][2] = {
+    { 0, 0 }, // s-curve
+    { 0, 0 }, // linear
+    { 0, 0 }, // steep
+    { 0, 0 }, // wide
+};
+BUILD_ASSERT(ARRAY_SIZE(cycle_baseline) == ARRAY_SIZE(golden), "one baseline per golden curve");
+
+// best of several batches, so an interrupt in one batch does not count against the event path
+static uint64_t cycles_per_event(const struct device *dev, const struct golden *g, const bool coupled) {
+    const int32_t max_v = ramp_max(g);
+    uint64_t best = UINT64_MAX;
+    for (uint32_t b = 0; b < CYCLE_BATCHES; b++) {
+        timing_t t0 = timing_counter_get();
+        for (uint32_t i = 0; i < CYCLE_EVENTS; i++) {
+            const int32_t v = 1 + (int32_t)(i % max_v);
+            if (coupled) {
+                feed(dev, INPUT_REL_X, v, false);
+                feed(dev, INPUT_REL_Y, -(v / 2), true);
+            } else {
+                feed(dev, INPUT_REL_X, v, true);
+            }
+        }
+        timing_t t1 = timing_counter_get();
+        best = MIN(best, timing_cycles_get(&t0, &t1) / (coupled ? 2 * CYCLE_EVENTS : CYCLE_EVENTS));
+    }
+    return best;
+}
+
+// Only the board scenario in testcase.yaml enables this, host cycle counts mean nothing.
+ZTEST(accel_curve, test_cycles) {
+    if (!IS_ENABLED(CONFIG_ACCEL_CURVE_TEST_PERF)) {
+        ztest_test_skip();
+    }
+
+#if IS_ENABLED(CONFIG_ACCEL_CURVE_TEST_PERF)
+    timing_init();
+    timing_start();
+    for (size_t c = 0; c < ARRAY_SIZE(golden); c++) {
+        const struct golden *g = &golden[c];
+        for (uint8_t p = 0; p < 2; p++) {
+            const bool coupled = p == 1;
+            const struct device *dev = coupled ? coupled_dev : single_dev;
+            load_golden(dev, g);
+            const uint64_t cycles = cycles_per_event(dev, g, coupled);
+            const uint64_t limit =
+                (uint64_t)cycle_baseline[c][p] * (100 + CONFIG_ACCEL_CURVE_TEST_CYCLES_MARGIN) / 100;
+            TC_PRINT("%s: %llu cycles per %s event, baseline %u\n", g->name, (unsigned long long)cycles,
+                     coupled ? "coupled" : "uncoupled", cycle_baseline[c][p]);
+            // expect rather than assert, so one run prints every value to store
+            zexpect_true(cycle_baseline[c][p] > 0 && cycles <= limit, "%s: %llu cycles per %s event, limit %llu",
+                         g->name, (unsigned long long)cycles, coupled ? "coupled" : "uncoupled",
+                         (unsigned long long)limit);
+        }
+    }
+    timing_stop();
+#endif
+}